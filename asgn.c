@@ -6,6 +6,11 @@
 #include "mylib.h"
 #include "htable.h"
 #include "tree.h"
+#include "hll.h"
+#include "check.h"
+#include "pipeline.h"
+#include "snapshot.h"
+#include "writer.h"
 
 /* A struct to represent the command line flags
  * given by the user.
@@ -20,25 +25,186 @@ struct flags {
     rbt_colour red_black;
     int snapshot_count;
     int table_size;
+    int distinct;
+    char *write_file;
+    int threads;
+    int freeze;
+    int keyed;
+    int merge;
+    int suggest;
 };
 
+/* Estimates the number of distinct words using a HyperLogLog estimator
+ * instead of building a table. Each input file gets its own estimator,
+ * which are then merged; files written with -w are merged directly.
+ * Reads stdin when no files are given.
+ *
+ * @param files the input file names
+ * @param num_files number of input files
+ * @param write_file file to save the merged estimator to, or NULL
+ *
+ * @return EXIT_SUCCESS, or EXIT_FAILURE if a file can't be opened
+ */
+static int estimate_distinct(char **files, int num_files, char *write_file){
+    hll total = hll_new();
+    hll part;
+    char word[256];
+    FILE *fptr;
+    int i;
+    if (num_files == 0){
+        while (getword(word, sizeof word, stdin) != EOF){
+            hll_add(total, word);
+        }
+    }
+    for (i = 0; i < num_files; i++){
+        if (NULL == (fptr = fopen(files[i], "rb"))){
+            fprintf(stderr, "Can't open file '%s' using mode r.\n", files[i]);
+            hll_free(total);
+            return EXIT_FAILURE;
+        }
+        if (NULL == (part = hll_load(fptr))){
+            part = hll_new();
+            while (getword(word, sizeof word, fptr) != EOF){
+                hll_add(part, word);
+            }
+        }
+        hll_merge(total, part);
+        hll_free(part);
+        fclose(fptr);
+    }
+    if (write_file != NULL){
+        if (NULL == (fptr = fopen(write_file, "wb"))){
+            fprintf(stderr, "Can't open file '%s' using mode w.\n", write_file);
+            hll_free(total);
+            return EXIT_FAILURE;
+        }
+        hll_save(total, fptr);
+        fclose(fptr);
+    }
+    printf("Distinct words: %.0f\n", hll_estimate(total));
+    printf("Standard error: %.2f%% (+/- %.0f)\n", 100.0 * hll_std_error(total),
+           hll_std_error(total) * hll_estimate(total));
+    hll_free(total);
+    return EXIT_SUCCESS;
+}
+
+/* Writes a merged key and frequency in the same format as htable_print. */
+static void print_merged(char *key, int freq, void *arg){
+    writer_int(arg, freq, -5);
+    writer_string(arg, key);
+    writer_char(arg, '\n');
+}
+
+/* Adds a merged key and frequency to a snapshot. */
+static void save_merged(char *key, int freq, void *arg){
+    snapshot_writer_add(arg, key, freq);
+}
+
+/* Merges snapshots saved with -w, printing the combined frequencies and
+ * words in key order, or saving them as another snapshot. Reads a single
+ * snapshot from stdin when no files are given. A merged snapshot is
+ * written to a temporary file that only replaces write_file once the
+ * whole merge has succeeded, so a failed merge never leaves behind a
+ * snapshot that looks complete.
+ *
+ * @param files the snapshot file names
+ * @param num_files number of snapshot files
+ * @param write_file file to save the merged snapshot to, or NULL
+ *
+ * @return EXIT_SUCCESS, or EXIT_FAILURE if a file can't be read
+ */
+static int merge_snapshots(char **files, int num_files, char *write_file){
+    int n = num_files > 0 ? num_files : 1;
+    FILE **streams = emalloc(n * sizeof streams[0]);
+    snapshot_reader *inputs = emalloc(n * sizeof inputs[0]);
+    snapshot_writer s;
+    FILE *out = NULL;
+    char *temp_file = NULL;
+    writer w;
+    int i, opened = 0, ok = 1;
+    for (i = 0; i < n; i++){
+        if (num_files == 0){
+            streams[i] = stdin;
+        }else if (NULL == (streams[i] = fopen(files[i], "rb"))){
+            fprintf(stderr, "Can't open file '%s' using mode r.\n", files[i]);
+            ok = 0;
+            break;
+        }
+        if (NULL == (inputs[i] = snapshot_reader_new(streams[i]))){
+            fprintf(stderr, "'%s' is not a snapshot.\n",
+                    num_files > 0 ? files[i] : "stdin");
+            if (num_files > 0){
+                fclose(streams[i]);
+            }
+            ok = 0;
+            break;
+        }
+        opened++;
+    }
+    if (ok && write_file != NULL){
+        temp_file = emalloc(strlen(write_file) + 5);
+        sprintf(temp_file, "%s.tmp", write_file);
+        if (NULL == (out = fopen(temp_file, "wb"))){
+            fprintf(stderr, "Can't open file '%s' using mode w.\n", temp_file);
+            ok = 0;
+        }
+    }
+    if (ok && out != NULL){
+        s = snapshot_writer_new(out);
+        ok = snapshot_merge(inputs, n, save_merged, s);
+        snapshot_writer_free(s);
+        if (fclose(out) != 0){
+            fprintf(stderr, "Can't write file '%s'.\n", temp_file);
+            ok = 0;
+        }
+        if (!ok){
+            remove(temp_file);
+        }else if (rename(temp_file, write_file) != 0){
+            fprintf(stderr, "Can't rename '%s' to '%s'.\n", temp_file,
+                    write_file);
+            remove(temp_file);
+            ok = 0;
+        }
+    }else if (ok){
+        w = writer_new(stdout);
+        ok = snapshot_merge(inputs, n, print_merged, w);
+        writer_free(w);
+    }
+    for (i = 0; i < opened; i++){
+        snapshot_reader_free(inputs[i]);
+        if (num_files > 0){
+            fclose(streams[i]);
+        }
+    }
+    free(temp_file);
+    free(inputs);
+    free(streams);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 /* Main method.
  *
  * @param argc total number of cmd arguments
  * @param argv array of cmd arguments
  */
 int main(int argc, char **argv){
-    const char *optstring = "Tc:deoprs:t:h";
+    const char *optstring = "Tbc:defgj:kmopqrs:t:uw:h";
     char option;
     struct flags f;
-    htable h;
+    htable h = NULL;
     tree b = NULL;
-    char word[256];
+    struct dictionary d;
+    pipeline words;
+    struct word_batch *batch;
+    char *word;
     FILE *fptr;
+    int i;
     int unknown_word_count = 0;
     double fill_time = 0.0;
+    double index_time = 0.0;
     double search_time = 0.0;
     clock_t start, end;
+    double batch_start;
     /* process command line options */
     f.tree = 0;
     f.hashing_method = LINEAR_P;
@@ -49,11 +215,21 @@ int main(int argc, char **argv){
     f.red_black = BST;
     f.snapshot_count = 0;
     f.table_size = 0;
+    f.distinct = 0;
+    f.write_file = NULL;
+    f.threads = 1;
+    f.freeze = 0;
+    f.keyed = 0;
+    f.merge = 0;
+    f.suggest = 0;
     while((option = getopt(argc, argv, optstring)) != EOF) {
         switch (option) {
             case 'T':
                 f.tree = 1;
                 break;
+            case 'b':
+                f.hashing_method = CUCKOO_H;
+                break;
             case 'c':
                 f.check_file = emalloc((strlen(optarg)+1) *
                                        sizeof f.check_file[0]);
@@ -65,12 +241,30 @@ int main(int argc, char **argv){
             case 'e':
                 f.entire_contents_printed = 1;
                 break;
+            case 'f':
+                f.freeze = 1;
+                break;
+            case 'g':
+                f.suggest = 1;
+                break;
+            case 'j':
+                f.threads = atoi(optarg);
+                break;
+            case 'k':
+                f.keyed = 1;
+                break;
+            case 'm':
+                f.merge = 1;
+                break;
             case 'o':
                 f.output_dot = 1;
                 break;
             case 'p':
                 f.print_stats = 1;
                 break;
+            case 'q':
+                f.hashing_method = QUADRATIC_P;
+                break;
             case 'r':
                 f.red_black = RBT;
                 break;
@@ -80,6 +274,12 @@ int main(int argc, char **argv){
             case 't':
                 f.table_size = atoi(optarg);
                 break;
+            case 'u':
+                f.distinct = 1;
+                break;
+            case 'w':
+                f.write_file = optarg;
+                break;
             case 'h':
             default:
                 print_help(argv[0]);
@@ -87,58 +287,113 @@ int main(int argc, char **argv){
         }
     }
 
+    if (f.distinct == 1){
+        return estimate_distinct(argv + optind, argc - optind, f.write_file);
+    }
+    if (f.merge == 1){
+        return merge_snapshots(argv + optind, argc - optind, f.write_file);
+    }
+
+    /* start reading words from the input files, or stdin if there are none */
+    if (NULL == (words = pipeline_new(argv + optind, argc - optind))){
+        return EXIT_FAILURE;
+    }
+
     /* setup the data structure (hash or tree/rbt) */
     if (f.tree == 0){
-        h = htable_new(table_size(f.table_size), f.hashing_method);
+        h = htable_new(table_size(f.table_size), f.hashing_method,
+                       (f.print_stats || f.entire_contents_printed ?
+                        HTABLE_STATS : 0) | (f.keyed ? HTABLE_KEYED : 0));
     } /* we do not need to setup the tree as this is done automatically when
          tree_insert is called, if it is passed a NULL pointer. */
     
-    /* get words from stdin */
-    while (getword(word, sizeof word, stdin) != EOF){
-        if (f.tree == 0){
-            start = clock();
-            htable_insert(h, word);
-            end = clock();
-        }else{
-            start = clock();
-            b = tree_insert(b, word, f.red_black);
-            b = tree_make_black(b);
-            end = clock();
+    /* get words from the pipeline, a batch at a time */
+    while ((batch = pipeline_next(words)) != NULL){
+        batch_start = wall_time();
+        for (i = 0, word = batch->words; i < batch->count; i++){
+            if (f.tree == 0){
+                htable_insert(h, word);
+            }else{
+                b = tree_insert(b, word, f.red_black);
+                b = tree_make_black(b);
+            }
+            word += strlen(word) + 1;
         }
-        fill_time += (end - start)/(double)CLOCKS_PER_SEC;
-    } 
+        fill_time += wall_time() - batch_start;
+        pipeline_release(words, batch);
+    }
+    pipeline_free(words);
+    /* stderr carries the unknown words when checking, so flood alerts are
+       reported with the timings there instead */
+    if (f.tree == 0 && f.check_file == NULL && htable_flood_alerts(h) > 0){
+        fprintf(stderr, "%d inserts took suspiciously many collisions, "
+                "possible hash flooding (-k uses a keyed hash)\n",
+                htable_flood_alerts(h));
+    }
     if (f.check_file != NULL){
         /* read file into another function then search and match words */
         if (NULL == (fptr = fopen(f.check_file, "r"))){
             fprintf(stderr, "Can't open file '%s' using mode r.\n", f.check_file);
             return EXIT_FAILURE;
         }
-        while (getword(word, sizeof word, fptr) != EOF){
-            if (f.tree == 0){
-                start = clock();
-                if (htable_search(h, word) == 0){
-                    end = clock();
-                    fprintf(stderr, "%s\n", word);
-                    unknown_word_count++;
-                }else{
-                    end = clock();
-                }
-            }else{
-                start = clock();
-                if (tree_search(b, word) == 0){
-                    end = clock();
-                    fprintf(stderr, "%s\n", word);
-                    unknown_word_count++;
-                }else{
-                    end = clock();
-                }
+        d.frozen = NULL;
+        d.h = f.tree == 0 ? h : NULL;
+        d.b = b;
+        d.suggest = NULL;
+        if (f.suggest == 1){
+            index_time = wall_time();
+            d.suggest = f.tree == 0 ? suggest_new_htable(h)
+                : suggest_new_tree(b);
+            index_time = wall_time() - index_time;
+        }
+        if (f.tree == 0 && f.freeze == 1){
+            start = clock();
+            d.frozen = htable_freeze(h);
+            end = clock();
+            fill_time += (end - start)/(double)CLOCKS_PER_SEC;
+            if (d.frozen == NULL){
+                fprintf(stderr, "Couldn't freeze the dictionary, using the "
+                        "hash table.\n");
             }
-            search_time += (end - start)/(double)CLOCKS_PER_SEC;
-        } 
+        }
+        unknown_word_count = check_words(&d, fptr, f.threads, &search_time);
+        fclose(fptr);
         printf("Fill time     : %f\n", fill_time);
+        if (f.tree == 0 && htable_flood_alerts(h) > 0){
+            printf("Flood alerts  : %d\n", htable_flood_alerts(h));
+        }
+        if (d.frozen != NULL){
+            printf("Frozen index  : %ld bits (%.2f per key)\n",
+                   mph_index_bits(d.frozen), mph_num_keys(d.frozen) > 0 ?
+                   mph_index_bits(d.frozen) / (double) mph_num_keys(d.frozen)
+                   : 0.0);
+            mph_free(d.frozen);
+        }
+        if (d.suggest != NULL){
+            printf("Index time    : %f\n", index_time);
+            printf("Index memory  : %lu\n",
+                   (unsigned long) suggest_memory(d.suggest));
+            suggest_free(d.suggest);
+        }
         printf("Search time   : %f\n", search_time);
         printf("Unknown words = %d\n", unknown_word_count);
+        if (f.tree == 0 && f.print_stats == 1){
+            htable_print_stats(h, stdout, f.snapshot_count == 0 ? 10 :
+                               f.snapshot_count);
+        }
 
+    }else if (f.write_file != NULL){
+        if (NULL == (fptr = fopen(f.write_file, "wb"))){
+            fprintf(stderr, "Can't open file '%s' using mode w.\n",
+                    f.write_file);
+            return EXIT_FAILURE;
+        }
+        if (f.tree == 0){
+            snapshot_save_htable(h, fptr);
+        }else{
+            snapshot_save_tree(b, fptr);
+        }
+        fclose(fptr);
     }else{
         if (f.tree == 0){
             if (f.entire_contents_printed == 1){
@@ -159,7 +414,7 @@ int main(int argc, char **argv){
                 fptr = fopen("tree-view.dot", "w");
                 tree_output_dot(b, fptr);
             }
-            tree_preorder(b, tree_print_key);
+            tree_print_preorder(b, stdout);
         }
     }
     if (f.tree == 0){
@@ -0,0 +1,270 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include "check.h"
+#include "mylib.h"
+#include "writer.h"
+
+/* Room for an unknown word and its suggestions, all of which are no
+ * longer than getword's limit.
+ */
+#define LINE_SIZE (256 * (SUGGEST_MAX + 2))
+
+/* A piece of the text being checked, and the results of checking it. */
+struct chunk {
+    struct dictionary *dict;
+    char *start;
+    char *end;
+    htable_counts counts;
+    char *unknown;
+    int unknown_len;
+    int unknown_capacity;
+    int unknown_count;
+};
+
+/* Looks a word up in the dictionary.
+ *
+ * @param d the dictionary to use
+ * @param word the word to look up
+ * @param counts probe counters to use if d is an htable
+ *
+ * @return 1 if the word is in the dictionary, 0 if not
+ */
+static int dictionary_search(struct dictionary *d, char *word,
+                             htable_counts counts){
+    if (d->frozen != NULL){
+        return mph_search(d->frozen, word);
+    }else if (d->h != NULL){
+        return htable_search_counted(d->h, word, counts);
+    }
+    return tree_search(d->b, word);
+}
+
+/* Formats an unknown word followed by a colon and its suggestions,
+ * separated by spaces.
+ *
+ * @param s the suggestion index
+ * @param word the unknown word
+ * @param line where to store the line, which must hold LINE_SIZE chars
+ *
+ * @return the length of the line
+ */
+static int suggest_line(suggest s, char *word, char *line){
+    char *found[SUGGEST_MAX];
+    int n = suggest_lookup(s, word, found, SUGGEST_MAX);
+    int len = strlen(word);
+    int i, flen;
+    memcpy(line, word, len);
+    line[len++] = ':';
+    for (i = 0; i < n; i++){
+        flen = strlen(found[i]);
+        line[len++] = ' ';
+        memcpy(line + len, found[i], flen);
+        len += flen;
+    }
+    line[len] = '\0';
+    return len;
+}
+
+/* Checks words one at a time as they are read, printing any that
+ * aren't in the dictionary to stderr.
+ *
+ * @param d the dictionary to check against
+ * @param in the stream to read words from
+ * @param search_time has the time spent searching added to it
+ *
+ * @return the number of unknown words
+ */
+static int check_serial(struct dictionary *d, FILE *in, double *search_time){
+    char word[256];
+    char line[LINE_SIZE];
+    clock_t start, end;
+    int unknown_word_count = 0;
+    int known;
+    while (getword(word, sizeof word, in) != EOF){
+        start = clock();
+        if (d->frozen != NULL){
+            known = mph_search(d->frozen, word);
+        }else if (d->h != NULL){
+            known = htable_search(d->h, word);
+        }else{
+            known = tree_search(d->b, word);
+        }
+        if (known == 0 && d->suggest != NULL){
+            suggest_line(d->suggest, word, line);
+        }
+        end = clock();
+        if (known == 0){
+            fprintf(stderr, "%s\n", d->suggest != NULL ? line : word);
+            unknown_word_count++;
+        }
+        *search_time += (end - start)/(double)CLOCKS_PER_SEC;
+    }
+    return unknown_word_count;
+}
+
+/* Thread body that checks every word in a chunk, saving the unknown
+ * ones (with their suggestions, if any), each followed by a newline,
+ * in the chunk's unknown buffer.
+ *
+ * @param arg the chunk to check
+ *
+ * @return NULL
+ */
+static void *check_chunk(void *arg){
+    struct chunk *c = arg;
+    char word[256];
+    char line[LINE_SIZE];
+    char *pos = c->start;
+    char *unknown;
+    int len;
+    while ((len = sgetword(word, sizeof word, &pos, c->end)) != EOF){
+        if (dictionary_search(c->dict, word, c->counts) == 0){
+            unknown = word;
+            if (c->dict->suggest != NULL){
+                len = suggest_line(c->dict->suggest, word, line);
+                unknown = line;
+            }
+            if (c->unknown_len + len + 1 > c->unknown_capacity){
+                c->unknown_capacity = 2 * (c->unknown_capacity + len + 1);
+                c->unknown = erealloc(c->unknown, c->unknown_capacity);
+            }
+            memcpy(c->unknown + c->unknown_len, unknown, len);
+            c->unknown_len += len;
+            c->unknown[c->unknown_len++] = '\n';
+            c->unknown_count++;
+        }
+    }
+    return NULL;
+}
+
+/* Reads the rest of a stream into memory.
+ *
+ * @param in the stream to read
+ * @param len set to the number of bytes read
+ *
+ * @return the text read, which must be freed
+ */
+static char *read_all(FILE *in, size_t *len){
+    size_t capacity = 65536;
+    size_t n;
+    char *text = emalloc(capacity);
+    *len = 0;
+    while ((n = fread(text + *len, 1, capacity - *len, in)) > 0){
+        *len += n;
+        if (*len == capacity){
+            capacity *= 2;
+            text = erealloc(text, capacity);
+        }
+    }
+    return text;
+}
+
+/* Returns true if a character can never be part of a word, so the text
+ * can safely be split there.
+ *
+ * @param c the character to check
+ */
+static int is_separator(char c){
+    return !isalnum((unsigned char) c) && '\'' != c;
+}
+
+/* Checks words using several threads. The text is read into memory and
+ * split between separators into one chunk per thread. The dictionary is
+ * only read while the threads run; each keeps its own unknown words and
+ * probe counters, which are output and merged in order afterwards.
+ *
+ * @param d the dictionary to check against
+ * @param in the stream to read words from
+ * @param threads number of threads to use
+ * @param search_time has the time spent searching added to it
+ *
+ * @return the number of unknown words
+ */
+static int check_parallel(struct dictionary *d, FILE *in, int threads,
+                          double *search_time){
+    size_t len;
+    char *text = read_all(in, &len);
+    char *end = text + len;
+    struct chunk *chunks = emalloc(threads * sizeof chunks[0]);
+    pthread_t *ids = emalloc(threads * sizeof ids[0]);
+    writer w;
+    double start;
+    int unknown_word_count = 0;
+    int i;
+
+    for (i = 0; i < threads; i++){
+        chunks[i].dict = d;
+        chunks[i].start = i == 0 ? text : chunks[i - 1].end;
+        chunks[i].end = i == threads - 1 ? end : text + len / threads * (i + 1);
+        if (chunks[i].end < chunks[i].start){
+            chunks[i].end = chunks[i].start;
+        }
+        while (chunks[i].end < end && !is_separator(*chunks[i].end)){
+            chunks[i].end++;
+        }
+        chunks[i].counts = d->frozen == NULL && d->h != NULL ?
+            htable_counts_new() : NULL;
+        chunks[i].unknown = NULL;
+        chunks[i].unknown_len = 0;
+        chunks[i].unknown_capacity = 0;
+        chunks[i].unknown_count = 0;
+    }
+
+    start = wall_time();
+    for (i = 0; i < threads; i++){
+        if (pthread_create(&ids[i], NULL, check_chunk, &chunks[i]) != 0){
+            fprintf(stderr, "thread creation failed.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (i = 0; i < threads; i++){
+        pthread_join(ids[i], NULL);
+    }
+    *search_time += wall_time() - start;
+
+    w = writer_new(stderr);
+    for (i = 0; i < threads; i++){
+        unknown_word_count += chunks[i].unknown_count;
+        if (chunks[i].unknown != NULL){
+            /* swap the last newline for a terminator to write it as a string */
+            chunks[i].unknown[chunks[i].unknown_len - 1] = '\0';
+            writer_string(w, chunks[i].unknown);
+            writer_char(w, '\n');
+            free(chunks[i].unknown);
+        }
+        if (chunks[i].counts != NULL){
+            htable_counts_merge(d->h, chunks[i].counts);
+        }
+    }
+    writer_free(w);
+    free(ids);
+    free(chunks);
+    free(text);
+    return unknown_word_count;
+}
+
+/* Checks the spelling of every word in a stream against a dictionary,
+ * printing the unknown words to stderr in the order they appear. If
+ * the dictionary has a suggestion index, each unknown word is followed
+ * by a colon and the suggestions for it.
+ *
+ * @param d the dictionary to check against
+ * @param in the stream to read words from
+ * @param threads number of threads to search with; 1 checks each word
+ * as it is read, and only the time spent searching is counted
+ * @param search_time has the time spent searching added to it
+ *
+ * @return the number of unknown words
+ */
+int check_words(struct dictionary *d, FILE *in, int threads,
+                double *search_time){
+    if (threads <= 1){
+        return check_serial(d, in, search_time);
+    }
+    return check_parallel(d, in, threads, search_time);
+}
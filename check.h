@@ -0,0 +1,25 @@
+#ifndef CHECK_H_
+#define CHECK_H_
+
+#include <stdio.h>
+#include "htable.h"
+#include "tree.h"
+#include "mph.h"
+#include "suggest.h"
+
+/* The dictionary to check words against. Only one of these is used:
+ * the frozen keys if they aren't NULL, then the htable if it isn't
+ * NULL, otherwise the tree. Unknown words are given suggestions if
+ * suggest isn't NULL.
+ */
+struct dictionary {
+    mph frozen;
+    htable h;
+    tree b;
+    suggest suggest;
+};
+
+extern int check_words(struct dictionary *d, FILE *in, int threads,
+                       double *search_time);
+
+#endif
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include "hll.h"
+#include "mylib.h"
+
+/* Number of index bits, giving 2^HLL_PRECISION registers. With 14 bits
+ * the estimator uses 16KB and has a standard error of about 0.8%.
+ */
+#define HLL_PRECISION 14
+#define HLL_REGISTERS (1 << HLL_PRECISION)
+#define HLL_MAGIC "HLL1"
+
+struct hllrec {
+    unsigned char *registers;
+};
+
+/* Hashes a word to 32 bits. This is FNV-1a followed by the murmur3
+ * finaliser, which spreads the entropy into the high bits that are
+ * used to pick a register.
+ *
+ * @param word the word to hash
+ *
+ * @return the hash of the word
+ */
+static unsigned int hll_hash(char *word){
+    unsigned int h = 2166136261u;
+    while (*word != '\0'){
+        h ^= (unsigned char) *word++;
+        h = (h * 16777619u) & 0xffffffffu;
+    }
+    return hash_mix(h);
+}
+
+/* Creates a new, empty estimator.
+ *
+ * @return new hll
+ */
+hll hll_new(void){
+    int i;
+    hll result = emalloc(sizeof *result);
+    result->registers = emalloc(HLL_REGISTERS * sizeof result->registers[0]);
+    for (i = 0; i < HLL_REGISTERS; i++){
+        result->registers[i] = 0;
+    }
+    return result;
+}
+
+/* Frees an estimator from memory.
+ *
+ * @param h the estimator to free
+ */
+void hll_free(hll h){
+    free(h->registers);
+    free(h);
+}
+
+/* Adds a word to the estimator. The top HLL_PRECISION bits of the hash
+ * choose a register, which keeps the longest run of leading zeros
+ * (plus one) seen in the remaining bits.
+ *
+ * @param h the estimator to add to
+ * @param str the word to add
+ */
+void hll_add(hll h, char *str){
+    unsigned int k = hll_hash(str);
+    unsigned int index = k >> (32 - HLL_PRECISION);
+    unsigned int rest = (k << HLL_PRECISION) & 0xffffffffu;
+    unsigned char rank = 1;
+    while (rank <= 32 - HLL_PRECISION && (rest & 0x80000000u) == 0){
+        rank++;
+        rest <<= 1;
+    }
+    if (rank > h->registers[index]){
+        h->registers[index] = rank;
+    }
+}
+
+/* Merges one estimator into another. The result estimates the number
+ * of distinct words added to either of them.
+ *
+ * @param dest the estimator to merge into
+ * @param src the estimator to merge from
+ */
+void hll_merge(hll dest, hll src){
+    int i;
+    for (i = 0; i < HLL_REGISTERS; i++){
+        if (src->registers[i] > dest->registers[i]){
+            dest->registers[i] = src->registers[i];
+        }
+    }
+}
+
+/* Estimates the number of distinct words added so far. Uses linear
+ * counting while many registers are still empty, and corrects for hash
+ * collisions once the estimate nears the size of the 32 bit hash space.
+ *
+ * @param h the estimator
+ *
+ * @return estimated number of distinct words
+ */
+double hll_estimate(hll h){
+    double m = HLL_REGISTERS;
+    double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double sum = 0.0;
+    double estimate;
+    double two_32 = 4294967296.0;
+    int zeros = 0;
+    int i;
+    for (i = 0; i < HLL_REGISTERS; i++){
+        sum += ldexp(1.0, -h->registers[i]);
+        if (h->registers[i] == 0){
+            zeros++;
+        }
+    }
+    estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0){
+        estimate = m * log(m / zeros);
+    }else if (estimate > two_32 / 30.0){
+        estimate = -two_32 * log(1.0 - estimate / two_32);
+    }
+    return estimate;
+}
+
+/* Returns the relative standard error of the estimator.
+ *
+ * @param h the estimator
+ *
+ * @return standard error as a fraction of the estimate
+ */
+double hll_std_error(hll h){
+    (void) h;
+    return 1.04 / sqrt((double) HLL_REGISTERS);
+}
+
+/* Writes an estimator to a stream so that it can be merged later.
+ *
+ * @param h the estimator to save
+ * @param stream the stream to write to
+ */
+void hll_save(hll h, FILE *stream){
+    fwrite(HLL_MAGIC, 1, 4, stream);
+    fputc(HLL_PRECISION, stream);
+    fwrite(h->registers, 1, HLL_REGISTERS, stream);
+}
+
+/* Reads an estimator written by hll_save. The stream is left where it
+ * was if it does not start with a saved estimator.
+ *
+ * @param stream the stream to read from
+ *
+ * @return the estimator, or NULL if the stream does not hold one
+ */
+hll hll_load(FILE *stream){
+    char magic[5];
+    long start = ftell(stream);
+    hll result;
+    magic[4] = '\0';
+    if (fread(magic, 1, 4, stream) != 4 || strcmp(magic, HLL_MAGIC) != 0
+        || fgetc(stream) != HLL_PRECISION){
+        fseek(stream, start, SEEK_SET);
+        return NULL;
+    }
+    result = hll_new();
+    if (fread(result->registers, 1, HLL_REGISTERS, stream) != HLL_REGISTERS){
+        hll_free(result);
+        fseek(stream, start, SEEK_SET);
+        return NULL;
+    }
+    return result;
+}
@@ -0,0 +1,17 @@
+#ifndef HLL_H_
+#define HLL_H_
+
+#include <stdio.h>
+
+typedef struct hllrec *hll;
+
+extern hll hll_new(void);
+extern void hll_free(hll h);
+extern void hll_add(hll h, char *str);
+extern void hll_merge(hll dest, hll src);
+extern double hll_estimate(hll h);
+extern double hll_std_error(hll h);
+extern void hll_save(hll h, FILE *stream);
+extern hll hll_load(FILE *stream);
+
+#endif
@@ -2,17 +2,268 @@
 #include <stdlib.h>
 #include "htable.h"
 #include <string.h>
+#include <time.h>
 #include "mylib.h"
-/* hello */
+#include "writer.h"
+#include "mph.h"
+
+/* Keys shorter than this are stored inside their slot. */
+#define INLINE_KEY_SIZE 20
+
+/* freq value marking a slot whose key has been deleted. Probing carries
+ * on past these, but inserts may reuse them.
+ */
+#define TOMBSTONE -1
+
+/* Once more than this percentage of slots are tombstones the table is
+ * rehashed to clear them, so that probe lengths don't keep growing.
+ */
+#define TOMBSTONE_PERCENT 20
+
+/* Insertion stats are kept a byte per key. Larger values are stored as
+ * STATS_OVERFLOW, with the real value kept in a separate, sorted list.
+ */
+#define STATS_OVERFLOW 255
+
+/* Shape of the table for cuckoo hashing: slots per bucket, number of
+ * overflow slots, and the longest chain of kick-outs tried per insert.
+ */
+#define CUCKOO_WAYS 4
+#define CUCKOO_STASH 4
+#define CUCKOO_MAX_KICKS 256
+
+/* An insert that needs more than FLOOD_PROBES collisions, plus one for
+ * every FLOOD_SCALE slots, while the table is at most FLOOD_PERCENT full
+ * is taken as a sign that someone is feeding in words chosen to collide.
+ * The limit grows with the table because the unkeyed hash packs short
+ * words into narrow ranges, so big tables of ordinary text have long
+ * clusters too. Alerts are counted for htable_print_stats; a keyed
+ * table also picks a new secret seed and rehashes, but an unkeyed table
+ * keeps its hash so that its output stays the same from run to run.
+ */
+#define FLOOD_PROBES 128
+#define FLOOD_SCALE 16
+#define FLOOD_PERCENT 50
+
+/* How many seeds a keyed rehash tries before giving up. */
+#define COMPACT_ATTEMPTS 16
+
+/* Probe lengths are bucketed by powers of two: 0, 1, 2, 3-4, 5-8, 9-16,
+ * 17-32 and 33+.
+ */
+#define PROBE_BUCKETS 8
+
+/* The kinds of table operation that probe lengths are recorded for. */
+typedef enum probe_op_e {
+    INSERT_NEW, INSERT_DUP, SEARCH_HIT, SEARCH_MISS, NUM_PROBE_OPS
+} probe_op;
+
+/* Running totals of the probe lengths for one kind of operation. These
+ * are only ever incremented, so they are cheap enough to always keep.
+ */
+struct probe_counter {
+    long ops;
+    long probes;
+    int max;
+    long hist[PROBE_BUCKETS];
+};
+
+/* A set of counters for every kind of operation. Threads searching the
+ * same table each keep their own, merging them in once they are done.
+ */
+struct htable_countsrec {
+    struct probe_counter op[NUM_PROBE_OPS];
+};
+
+/* One entry in the table. The key's hash and length are kept alongside
+ * it so most mismatches are found without looking at the key. Short keys
+ * are stored in the slot itself, so a probe only touches the table; keys
+ * of INLINE_KEY_SIZE or more are allocated separately and a pointer to
+ * them is kept in key instead.
+ */
+struct slot {
+    unsigned int hash;
+    int freq;
+    unsigned int len;
+    char key[INLINE_KEY_SIZE];
+};
+
+/* A way of probing the table for a key. See the probing strategies
+ * below htable_word_to_int.
+ */
+struct probe_strategy {
+    char *name;
+    int (*insert)(htable ht, char *str, unsigned int k, unsigned int len,
+                  int *probes);
+    int (*find)(htable ht, char *str, unsigned int k, unsigned int len,
+                int *probes);
+};
+
 struct htablerec {
     int capacity;
+    int max_keys;
     int num_keys;
-    int* freqs;
-    char** keys;
-    int* stats;
+    int num_tombstones;
+    struct slot* slots;
+    unsigned char* stats;
+    int stats_len;
+    int stats_capacity;
+    int* overflow_index;
+    int* overflow_value;
+    int num_overflow;
     hashing_t method;
+    const struct probe_strategy *probe;
+    int keyed;
+    unsigned int seed[2];
+    int floods;
+    int num_buckets;
+    int stash_used;
+    long kicks;
+    int max_kicks;
+    unsigned int kick_state;
+    struct htable_countsrec counters;
 };
 
+/* Records the probe length of a single table operation.
+ *
+ * @param counts the counters to add to
+ * @param op the kind of operation
+ * @param probes number of collisions before the operation finished
+ */
+static void probe_record(htable_counts counts, probe_op op, int probes){
+    struct probe_counter *c = &counts->op[op];
+    int bucket = 0;
+    int n;
+    if (probes > 0){
+        /* 1 + ceil(log2(probes)) */
+        for (bucket = 1, n = probes - 1; n > 0; n >>= 1){
+            bucket++;
+        }
+        if (bucket >= PROBE_BUCKETS){
+            bucket = PROBE_BUCKETS - 1;
+        }
+    }
+    c->ops++;
+    c->probes += probes;
+    if (probes > c->max){
+        c->max = probes;
+    }
+    c->hist[bucket]++;
+}
+
+/* Records the number of collisions it took to place a new key. Does
+ * nothing if the table was created without HTABLE_STATS.
+ *
+ * @param h the htable the key was placed in
+ * @param collisions number of collisions before the key was placed
+ */
+static void stats_add(htable h, int collisions){
+    if (h->stats_capacity == 0){
+        return;
+    }
+    if (h->stats_len == h->stats_capacity){
+        h->stats_capacity *= 2;
+        h->stats = erealloc(h->stats, h->stats_capacity * sizeof h->stats[0]);
+    }
+    if (collisions >= STATS_OVERFLOW){
+        h->overflow_index = erealloc(h->overflow_index, (h->num_overflow + 1)
+                                     * sizeof h->overflow_index[0]);
+        h->overflow_value = erealloc(h->overflow_value, (h->num_overflow + 1)
+                                     * sizeof h->overflow_value[0]);
+        h->overflow_index[h->num_overflow] = h->stats_len;
+        h->overflow_value[h->num_overflow] = collisions;
+        h->num_overflow++;
+        collisions = STATS_OVERFLOW;
+    }
+    h->stats[h->stats_len++] = collisions;
+}
+
+/* Returns the number of collisions it took to place the nth new key.
+ *
+ * @param h the htable to look in
+ * @param n which key, in order of insertion
+ *
+ * @return the number of collisions, or 0 if n keys haven't been recorded
+ */
+static int stats_get(htable h, int n){
+    int lo = 0, hi = h->num_overflow - 1, mid;
+    if (n >= h->stats_len){
+        return 0;
+    }
+    if (h->stats[n] != STATS_OVERFLOW){
+        return h->stats[n];
+    }
+    while (lo < hi){ /* overflow_index is in increasing order */
+        mid = (lo + hi) / 2;
+        if (h->overflow_index[mid] < n){
+            lo = mid + 1;
+        }else{
+            hi = mid;
+        }
+    }
+    return h->overflow_value[lo];
+}
+
+/* Returns the key stored in a slot.
+ *
+ * @param s an occupied slot
+ *
+ * @return the slot's key
+ */
+static char *slot_key(struct slot *s){
+    char *key;
+    if (s->len < INLINE_KEY_SIZE){
+        return s->key;
+    }
+    memcpy(&key, s->key, sizeof key);
+    return key;
+}
+
+/* Stores a key in an empty slot, in the slot itself if it is short
+ * enough, otherwise in a new allocation.
+ *
+ * @param s the slot to use
+ * @param str the key to store
+ * @param k the hash of the key
+ * @param len the length of the key
+ */
+static void slot_set_key(struct slot *s, char *str, unsigned int k,
+                         unsigned int len){
+    char *key;
+    s->hash = k;
+    s->len = len;
+    if (len < INLINE_KEY_SIZE){
+        memcpy(s->key, str, len + 1);
+    }else{
+        key = emalloc((len+1) * sizeof key[0]);
+        memcpy(key, str, len + 1);
+        memcpy(s->key, &key, sizeof key);
+    }
+}
+
+/* Frees a slot's key if it was allocated separately.
+ *
+ * @param s an occupied slot
+ */
+static void slot_free_key(struct slot *s){
+    if (s->len >= INLINE_KEY_SIZE){
+        free(slot_key(s));
+    }
+}
+
+/* Returns true if a slot holds a particular key.
+ *
+ * @param s an occupied slot
+ * @param str the key to look for
+ * @param k the hash of the key
+ * @param len the length of the key
+ */
+static int slot_matches(struct slot *s, char *str, unsigned int k,
+                        unsigned int len){
+    return s->hash == k && s->len == len
+        && memcmp(slot_key(s), str, len) == 0;
+}
+
 /* Frees the entire hash table from memory.
  *
  * @param h the htable to free
@@ -20,13 +271,14 @@ struct htablerec {
 void htable_free(htable h){
     int i;
     for (i=0; i<h->capacity; i++){
-        if (h->freqs[i] >= 1){
-            free(h->keys[i]);
+        if (h->slots[i].freq >= 1){
+            slot_free_key(&h->slots[i]);
         }
     }
-    free(h->keys);
-    free(h->freqs);
+    free(h->slots);
     free(h->stats);
+    free(h->overflow_index);
+    free(h->overflow_value);
     free(h);
 }
 
@@ -45,117 +297,682 @@ static unsigned int htable_word_to_int(char *word){
     return result;
 }
 
-/* Enters data into the hash table using linear probing.
- * Uses the formula:
+#define ROTL32(x, b) ((((x) << (b)) | ((x) >> (32 - (b)))) & 0xffffffffu)
+
+/* One SipRound of HalfSipHash. */
+#define HALFSIP_ROUND(v0, v1, v2, v3) do { \
+        v0 = (v0 + v1) & 0xffffffffu; v1 = ROTL32(v1, 5); v1 ^= v0; \
+        v0 = ROTL32(v0, 16); \
+        v2 = (v2 + v3) & 0xffffffffu; v3 = ROTL32(v3, 8); v3 ^= v2; \
+        v0 = (v0 + v3) & 0xffffffffu; v3 = ROTL32(v3, 7); v3 ^= v0; \
+        v2 = (v2 + v1) & 0xffffffffu; v1 = ROTL32(v1, 13); v1 ^= v2; \
+        v2 = ROTL32(v2, 16); \
+    } while (0)
+
+/* Converts a word to an integer with HalfSipHash-1-3, keyed by the
+ * table's secret seed. Without knowing the seed, nobody can pick words
+ * that all land on the same probe sequence.
+ *
+ * @param ht the htable whose seed to use
+ * @param word the word to hash
+ * @param len the length of the word
+ *
+ * @return the hash of the word
+ */
+static unsigned int htable_keyed_hash(htable ht, char *word, unsigned int len){
+    unsigned char *p = (unsigned char *) word;
+    unsigned int v0 = ht->seed[0];
+    unsigned int v1 = ht->seed[1];
+    unsigned int v2 = 0x6c796765u ^ ht->seed[0];
+    unsigned int v3 = 0x74656462u ^ ht->seed[1];
+    unsigned int b = (len << 24) & 0xffffffffu;
+    unsigned int m;
+    unsigned int left = len;
+    for (; left >= 4; left -= 4, p += 4){
+        m = p[0] | (p[1] << 8) | ((unsigned int) p[2] << 16)
+            | ((unsigned int) p[3] << 24);
+        v3 ^= m;
+        HALFSIP_ROUND(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+    switch (left){
+        case 3:
+            b |= (unsigned int) p[2] << 16;
+            /* fall through */
+        case 2:
+            b |= (unsigned int) p[1] << 8;
+            /* fall through */
+        case 1:
+            b |= p[0];
+            break;
+    }
+    v3 ^= b;
+    HALFSIP_ROUND(v0, v1, v2, v3);
+    v0 ^= b;
+    v2 ^= 0xff;
+    HALFSIP_ROUND(v0, v1, v2, v3);
+    HALFSIP_ROUND(v0, v1, v2, v3);
+    HALFSIP_ROUND(v0, v1, v2, v3);
+    return v1 ^ v3;
+}
+
+/* Hashes a word with whichever hash the table is using.
+ *
+ * @param ht the htable to hash for
+ * @param word the word to hash
+ * @param len the length of the word
+ *
+ * @return the hash of the word
+ */
+static unsigned int htable_hash(htable ht, char *word, unsigned int len){
+    if (ht->keyed){
+        return htable_keyed_hash(ht, word, len);
+    }
+    return htable_word_to_int(word);
+}
+
+/* Picks a new secret seed for keyed hashing, from /dev/urandom if it
+ * is available, otherwise from the time and the table's address.
+ *
+ * @param ht the htable to seed
+ */
+static void htable_reseed(htable ht){
+    FILE *random = fopen("/dev/urandom", "rb");
+    unsigned int fallback = (unsigned int) time(NULL) ^ (unsigned int) clock();
+    if (random == NULL
+        || fread(ht->seed, sizeof ht->seed[0], 2, random) != 2){
+        ht->seed[0] = (fallback * 2654435761u) & 0xffffffffu;
+        ht->seed[1] = ((unsigned int) (size_t) ht ^ ht->seed[1] ^ fallback)
+            * 2246822519u & 0xffffffffu;
+    }
+    if (random != NULL){
+        fclose(random);
+    }
+}
+
+/* Each probing strategy below has two loops, selected once by
+ * htable_new. Both are given the key along with its hash k and length,
+ * which are worked out once per operation, and set probes to the number
+ * of collisions before they finished.
+ *
+ * The insert loop returns the slot holding the key or, if it isn't in
+ * the table, the slot it should go in: the first tombstone on its probe
+ * sequence, otherwise the empty slot that ended it. It returns -1 if
+ * there is no room.
+ *
+ * The find loop skips tombstones and returns the slot holding the key,
+ * or -1 if it isn't in the table.
+ */
+
+/* Works out the result of an insert loop that didn't find its key.
+ *
+ * @param pos the empty slot that ended the probe sequence, or -1
+ * @param i number of collisions before reaching pos
+ * @param tomb the first tombstone seen, or -1
+ * @param tomb_i number of collisions before reaching tomb
+ * @param probes set to the number of collisions before the chosen slot
+ *
+ * @return the slot to insert into, or -1 if there is no room
+ */
+static int insert_slot(int pos, int i, int tomb, int tomb_i, int *probes){
+    if (tomb >= 0){
+        *probes = tomb_i;
+        return tomb;
+    }
+    *probes = i;
+    return pos;
+}
+
+/* Linear probing, using the formula:
  * H(k, i) = (h(k) + i) % m
  * Where h(k) = k % m
- *
- * @param ht the htable to use
- * @param str the char array to enter
  */
-int linear_probing(htable ht, char *str){
-    unsigned int h, k, fhash;
-    int i = 0;
-	k = htable_word_to_int(str);
-    for(;;){
-        h = k % ht->capacity;
-        fhash = (h + i) % ht->capacity;
-        if (ht->freqs[fhash] == 0){
-            break; /* empty slot */
-        } else if (strcmp(ht->keys[fhash], str) == 0){
-            break; /* duplicate */
-        } else {
-            i++;
-        }
-        if (i > ht->capacity){
-            return 0;
+static int linear_insert(htable ht, char *str, unsigned int k,
+                         unsigned int len, int *probes){
+    struct slot *slots = ht->slots;
+    unsigned int m = ht->capacity;
+    unsigned int pos = k % m;
+    int tomb = -1, tomb_i = 0;
+    int i;
+    for (i = 0; i <= ht->capacity; i++){
+        if (slots[pos].freq == 0){
+            return insert_slot(pos, i, tomb, tomb_i, probes);
+        }else if (slots[pos].freq == TOMBSTONE){
+            if (tomb < 0){
+                tomb = pos;
+                tomb_i = i;
+            }
+        }else if (slot_matches(&slots[pos], str, k, len)){
+            *probes = i;
+            return pos;
+        }
+        if (++pos == m){
+            pos = 0;
         }
     }
-    ht->freqs[fhash]++;
-    if (ht->freqs[fhash] == 1){ /* if freqs = 1 then this is the first item,
-                                   not duplicate */
-        ht->keys[fhash] = emalloc((strlen(str)+1) * sizeof ht->keys[0]);
-        strcpy(ht->keys[fhash], str);
-        ht->stats[ht->num_keys] = i;
-		ht->num_keys++;
+    return insert_slot(-1, i, tomb, tomb_i, probes);
+}
+
+/* The find loop for linear probing, following the same probe sequence
+ * as linear_insert. See the comment above insert_slot.
+ *
+ * @param ht the htable to search
+ * @param str the key to find
+ * @param k the hash of the key
+ * @param len the length of the key
+ * @param probes set to the number of collisions
+ *
+ * @return the slot holding the key, or -1 if it isn't in the table
+ */
+static int linear_find(htable ht, char *str, unsigned int k,
+                       unsigned int len, int *probes){
+    struct slot *slots = ht->slots;
+    unsigned int m = ht->capacity;
+    unsigned int pos = k % m;
+    int i;
+    for (i = 0; i < ht->capacity; i++){
+        if (slots[pos].freq == 0){
+            break;
+        }else if (slots[pos].freq != TOMBSTONE
+                  && slot_matches(&slots[pos], str, k, len)){
+            *probes = i;
+            return pos;
+        }
+        if (++pos == m){
+            pos = 0;
+        }
     }
-    return 1;
+    *probes = i;
+    return -1;
 }
 
-/* Enters data into the hash table using double hashing.
- * This method uses the formula:
+/* Double hashing, using the formula:
  * H(k,i) = (h(k) + i * g(k)) % m
  * where h(k) = k % m
  * and g(k) = 1 + k % (m - 1)
+ */
+static int double_insert(htable ht, char *str, unsigned int k,
+                         unsigned int len, int *probes){
+    struct slot *slots = ht->slots;
+    unsigned int m = ht->capacity;
+    unsigned int pos = k % m;
+    unsigned int step = 1 + k % (m - 1);
+    int tomb = -1, tomb_i = 0;
+    int i;
+    for (i = 0; i <= ht->capacity; i++){
+        if (slots[pos].freq == 0){
+            return insert_slot(pos, i, tomb, tomb_i, probes);
+        }else if (slots[pos].freq == TOMBSTONE){
+            if (tomb < 0){
+                tomb = pos;
+                tomb_i = i;
+            }
+        }else if (slot_matches(&slots[pos], str, k, len)){
+            *probes = i;
+            return pos;
+        }
+        pos += step;
+        if (pos >= m){
+            pos -= m;
+        }
+    }
+    return insert_slot(-1, i, tomb, tomb_i, probes);
+}
+
+/* The find loop for double hashing, following the same probe sequence
+ * as double_insert. See the comment above insert_slot.
  *
- * @param ht htable to use
- * @param str string to enter
- */
-int double_hash(htable ht, char *str){
-    unsigned int fhash, h, g, k;
-    int i=0; 
-	k = htable_word_to_int(str);
-    for (;;){
-        h = k % ht->capacity;
-        g = 1 + k % (ht->capacity -1);
-        fhash = (h + (i * g)) % ht->capacity;
-        if (ht->freqs[fhash] == 0){
-            break; 
-        }else if (strcmp(ht->keys[fhash], str) == 0){ 
-            break; 	
-        }else{
-            i++;
+ * @param ht the htable to search
+ * @param str the key to find
+ * @param k the hash of the key
+ * @param len the length of the key
+ * @param probes set to the number of collisions
+ *
+ * @return the slot holding the key, or -1 if it isn't in the table
+ */
+static int double_find(htable ht, char *str, unsigned int k,
+                       unsigned int len, int *probes){
+    struct slot *slots = ht->slots;
+    unsigned int m = ht->capacity;
+    unsigned int pos = k % m;
+    unsigned int step = 1 + k % (m - 1);
+    int i;
+    for (i = 0; i < ht->capacity; i++){
+        if (slots[pos].freq == 0){
+            break;
+        }else if (slots[pos].freq != TOMBSTONE
+                  && slot_matches(&slots[pos], str, k, len)){
+            *probes = i;
+            return pos;
         }
-        if (i > ht->capacity){
-            return 0;
+        pos += step;
+        if (pos >= m){
+            pos -= m;
+        }
+    }
+    *probes = i;
+    return -1;
+}
+
+/* Quadratic probing with triangular numbers, using the formula:
+ * H(k, i) = (h(k) + i * (i + 1) / 2) % m
+ * Where h(k) = k % m
+ * As m is prime this only reaches (m + 1) / 2 of the slots, so the table
+ * holds at most that many keys. Then every key always has a free slot
+ * it can reach, however the others are placed, which compaction relies
+ * on to put every key back.
+ */
+static int quadratic_insert(htable ht, char *str, unsigned int k,
+                            unsigned int len, int *probes){
+    struct slot *slots = ht->slots;
+    unsigned int m = ht->capacity;
+    unsigned int pos = k % m;
+    int tomb = -1, tomb_i = 0;
+    int i;
+    for (i = 0; i <= ht->capacity; i++){
+        if (slots[pos].freq == 0){
+            return insert_slot(pos, i, tomb, tomb_i, probes);
+        }else if (slots[pos].freq == TOMBSTONE){
+            if (tomb < 0){
+                tomb = pos;
+                tomb_i = i;
+            }
+        }else if (slot_matches(&slots[pos], str, k, len)){
+            *probes = i;
+            return pos;
         }
+        pos = (pos + i + 1) % m;
     }
-	ht->freqs[fhash]++;
-    if (ht->freqs[fhash] == 1){ 
-        ht->stats[ht->num_keys] = i;
-        ht->keys[fhash] = emalloc((strlen(str)+1) * sizeof ht->keys[0]);
-        strcpy(ht->keys[fhash], str);
-		ht->num_keys++;
+    return insert_slot(-1, i, tomb, tomb_i, probes);
+}
+
+/* The find loop for quadratic probing, following the same probe sequence
+ * as quadratic_insert. See the comment above insert_slot.
+ *
+ * @param ht the htable to search
+ * @param str the key to find
+ * @param k the hash of the key
+ * @param len the length of the key
+ * @param probes set to the number of collisions
+ *
+ * @return the slot holding the key, or -1 if it isn't in the table
+ */
+static int quadratic_find(htable ht, char *str, unsigned int k,
+                          unsigned int len, int *probes){
+    struct slot *slots = ht->slots;
+    unsigned int m = ht->capacity;
+    unsigned int pos = k % m;
+    int i;
+    for (i = 0; i < ht->capacity; i++){
+        if (slots[pos].freq == 0){
+            break;
+        }else if (slots[pos].freq != TOMBSTONE
+                  && slot_matches(&slots[pos], str, k, len)){
+            *probes = i;
+            return pos;
+        }
+        pos = (pos + i + 1) % m;
     }
-    return 1;
+    *probes = i;
+    return -1;
+}
+
+/* Bucketized cuckoo hashing. The slots are split into buckets of
+ * CUCKOO_WAYS, followed by a stash of CUCKOO_STASH slots. Each key can
+ * only be in one of two buckets, or the stash, so a lookup never looks
+ * at more than two buckets. When both of a new key's buckets are full,
+ * keys are kicked out to their other bucket to make room.
+ *
+ * For cuckoo hashing the collisions recorded for a new key are the
+ * number of keys kicked out to place it, and for other operations the
+ * number of buckets looked at after the first (2 for the stash).
+ */
+
+/* Returns the first bucket a key may be in.
+ *
+ * @param ht the htable to use
+ * @param k the hash of the key
+ */
+static int cuckoo_bucket1(htable ht, unsigned int k){
+    return k % ht->num_buckets;
+}
+
+/* Returns the second bucket a key may be in. This remixes the hash so
+ * that keys sharing a first bucket are spread over different second
+ * buckets, and is never the same as the first bucket.
+ *
+ * @param ht the htable to use
+ * @param k the hash of the key
+ */
+static int cuckoo_bucket2(htable ht, unsigned int k){
+    int b1 = k % ht->num_buckets;
+    int b2;
+    b2 = hash_mix(k) % ht->num_buckets;
+    if (b2 == b1){
+        b2 = (b1 + 1) % ht->num_buckets;
+    }
+    return b2;
 }
 
-/* Inserts a new value into the hash table.
- * This passes the insertion role to either
- * linear_probing or double_hash depending
- * on the set options
+/* Returns the next number from the table's xorshift generator, used to
+ * choose which key to kick out.
+ *
+ * @param ht the htable to use
+ */
+static unsigned int cuckoo_random(htable ht){
+    unsigned int x = ht->kick_state;
+    x ^= (x << 13) & 0xffffffffu;
+    x ^= x >> 17;
+    x ^= (x << 5) & 0xffffffffu;
+    ht->kick_state = x;
+    return x;
+}
+
+/* The find loop for cuckoo hashing. Looks through the key's two
+ * buckets, then the stash if anything is in it.
+ *
+ * @param ht the htable to search
+ * @param str the key to find
+ * @param k the hash of the key
+ * @param len the length of the key
+ * @param probes set to the number of buckets looked at after the first,
+ * 2 if the stash was searched
+ *
+ * @return the slot holding the key, or -1 if it isn't in the table
+ */
+static int cuckoo_find(htable ht, char *str, unsigned int k,
+                       unsigned int len, int *probes){
+    struct slot *slots = ht->slots;
+    int b[2];
+    int i, j, pos;
+    b[0] = cuckoo_bucket1(ht, k);
+    b[1] = cuckoo_bucket2(ht, k);
+    for (i = 0; i < 2; i++){
+        pos = b[i] * CUCKOO_WAYS;
+        for (j = 0; j < CUCKOO_WAYS; j++, pos++){
+            if (slots[pos].freq > 0 && slot_matches(&slots[pos], str, k, len)){
+                *probes = i;
+                return pos;
+            }
+        }
+    }
+    *probes = 1;
+    if (ht->stash_used > 0){
+        *probes = 2;
+        pos = ht->num_buckets * CUCKOO_WAYS;
+        for (j = 0; j < CUCKOO_STASH; j++, pos++){
+            if (slots[pos].freq > 0 && slot_matches(&slots[pos], str, k, len)){
+                return pos;
+            }
+        }
+    }
+    return -1;
+}
+
+/* Looks for a chain of keys that can each be moved to their other
+ * bucket, ending at an empty slot, by walking randomly from one of the
+ * new key's buckets. If one is found the keys are moved along it, which
+ * leaves the chain's first slot free for the new key.
+ *
+ * @param ht the htable to use
+ * @param k the hash of the new key
+ *
+ * @return the freed slot, or -1 if no chain was found
+ */
+static int cuckoo_kick(htable ht, unsigned int k){
+    struct slot *slots = ht->slots;
+    int path[CUCKOO_MAX_KICKS];
+    int n, m, j, b, pos, way;
+    b = cuckoo_random(ht) & 1 ? cuckoo_bucket1(ht, k) : cuckoo_bucket2(ht, k);
+    for (n = 0; n < CUCKOO_MAX_KICKS; n++){
+        /* pick a key in bucket b that isn't already on the chain */
+        way = cuckoo_random(ht) % CUCKOO_WAYS;
+        for (j = 0; j < CUCKOO_WAYS; j++){
+            pos = b * CUCKOO_WAYS + (way + j) % CUCKOO_WAYS;
+            for (m = 0; m < n && path[m] != pos; m++){
+                ;
+            }
+            if (m == n){
+                break;
+            }
+        }
+        if (j == CUCKOO_WAYS){
+            return -1;
+        }
+        path[n] = pos;
+        b = pos / CUCKOO_WAYS == cuckoo_bucket1(ht, slots[pos].hash)
+            ? cuckoo_bucket2(ht, slots[pos].hash)
+            : cuckoo_bucket1(ht, slots[pos].hash);
+        for (j = 0; j < CUCKOO_WAYS; j++){
+            pos = b * CUCKOO_WAYS + j;
+            if (slots[pos].freq <= 0){
+                /* move each key along one step, starting from the end */
+                for (m = n; m >= 0; m--){
+                    slots[pos] = slots[path[m]];
+                    pos = path[m];
+                }
+                slots[pos].freq = 0;
+                ht->kicks += n + 1;
+                if (n + 1 > ht->max_kicks){
+                    ht->max_kicks = n + 1;
+                }
+                return pos;
+            }
+        }
+    }
+    return -1;
+}
+
+/* The insert loop for cuckoo hashing. A new key goes in a free slot of
+ * either of its buckets, otherwise keys are kicked out to make room,
+ * and as a last resort it goes in the stash.
+ *
+ * @param ht the htable to insert into
+ * @param str the key to insert
+ * @param k the hash of the key
+ * @param len the length of the key
+ * @param probes set to the number of keys kicked out, or as for
+ * cuckoo_find if the key is already in the table
+ *
+ * @return the slot holding or freed for the key, or -1 if there is no
+ * room
+ */
+static int cuckoo_insert(htable ht, char *str, unsigned int k,
+                         unsigned int len, int *probes){
+    struct slot *slots = ht->slots;
+    int b[2];
+    int i, j, pos;
+    if ((pos = cuckoo_find(ht, str, k, len, probes)) >= 0){
+        return pos;
+    }
+    *probes = 0;
+    b[0] = cuckoo_bucket1(ht, k);
+    b[1] = cuckoo_bucket2(ht, k);
+    for (i = 0; i < 2; i++){
+        pos = b[i] * CUCKOO_WAYS;
+        for (j = 0; j < CUCKOO_WAYS; j++, pos++){
+            if (slots[pos].freq <= 0){
+                return pos;
+            }
+        }
+    }
+    i = ht->kicks;
+    if ((pos = cuckoo_kick(ht, k)) >= 0){
+        *probes = ht->kicks - i;
+        return pos;
+    }
+    pos = ht->num_buckets * CUCKOO_WAYS;
+    for (j = 0; j < CUCKOO_STASH; j++, pos++){
+        if (slots[pos].freq <= 0){
+            ht->stash_used++;
+            return pos;
+        }
+    }
+    return -1;
+}
+
+/* The probing strategies, indexed by hashing_t. */
+static const struct probe_strategy strategies[] = {
+    { "Linear Probing", linear_insert, linear_find },
+    { "Double Hashing", double_insert, double_find },
+    { "Quadratic Probing", quadratic_insert, quadratic_find },
+    { "Cuckoo Hashing", cuckoo_insert, cuckoo_find }
+};
+
+static void htable_compact(htable ht, int rehash);
+
+/* Inserts a new value into the hash table, or increases its frequency
+ * if it is already there. The probing is done by the table's strategy.
+ * If the insert takes suspiciously many collisions a flood alert is
+ * counted, and a keyed table is rehashed with a new seed first.
  *
  * @param ht the hash table to insert into
  * @param str the string to insert
+ *
+ * @return 1 if the string was inserted, 0 if the table is full
  */
 int htable_insert(htable ht, char *str){
-    if (ht->method == LINEAR_P){
-        return linear_probing(ht, str);
-    }else{
-        return double_hash(ht, str);
+    unsigned int len = strlen(str);
+    unsigned int k = htable_hash(ht, str, len);
+    struct slot *s;
+    int probes;
+    int pos = ht->probe->insert(ht, str, k, len, &probes);
+    if ((pos < 0 || probes > FLOOD_PROBES + ht->capacity / FLOOD_SCALE)
+        && ht->num_keys * 100 <= ht->capacity * FLOOD_PERCENT){
+        ht->floods++;
+        if (ht->keyed){
+            htable_reseed(ht);
+            htable_compact(ht, 1);
+            k = htable_hash(ht, str, len);
+            pos = ht->probe->insert(ht, str, k, len, &probes);
+        }
+    }
+    if (pos < 0){
+        return 0;
+    }
+    s = &ht->slots[pos];
+    if (s->freq > 0){
+        s->freq++;
+        probe_record(&ht->counters, INSERT_DUP, probes);
+        return 1;
+    }
+    if (ht->num_keys >= ht->max_keys){
+        return 0;
+    }
+    if (s->freq == TOMBSTONE){
+        ht->num_tombstones--;
+    }
+    s->freq = 1;
+    slot_set_key(s, str, k, len);
+    stats_add(ht, probes);
+    ht->num_keys++;
+    probe_record(&ht->counters, INSERT_NEW, probes);
+    return 1;
+}
+
+/* Resets a set of probe counters to zero.
+ *
+ * @param counts the counters to reset
+ */
+static void htable_counts_clear(htable_counts counts){
+    int i, j;
+    for (i=0; i<NUM_PROBE_OPS; i++){
+        counts->op[i].ops = 0;
+        counts->op[i].probes = 0;
+        counts->op[i].max = 0;
+        for (j=0; j<PROBE_BUCKETS; j++){
+            counts->op[i].hist[j] = 0;
+        }
+    }
+}
+
+/* Creates a set of probe counters for use with htable_search_counted.
+ *
+ * @return new counters, all zero
+ */
+htable_counts htable_counts_new(void){
+    htable_counts result = emalloc(sizeof *result);
+    htable_counts_clear(result);
+    return result;
+}
+
+/* Adds a set of probe counters into a table's own counters, then frees
+ * them. This must not be called while other threads use the table.
+ *
+ * @param h the htable the counted searches were done on
+ * @param counts the counters to merge and free
+ */
+void htable_counts_merge(htable h, htable_counts counts){
+    struct probe_counter *to, *from;
+    int i, j;
+    for (i=0; i<NUM_PROBE_OPS; i++){
+        to = &h->counters.op[i];
+        from = &counts->op[i];
+        to->ops += from->ops;
+        to->probes += from->probes;
+        if (from->max > to->max){
+            to->max = from->max;
+        }
+        for (j=0; j<PROBE_BUCKETS; j++){
+            to->hist[j] += from->hist[j];
+        }
     }
+    free(counts);
 }
 
 /* Creates and return a new htable.
  *
- * @param capacity maximum size of the hash table
+ * @param capacity maximum size of the hash table; cuckoo hashing rounds
+ * this up to whole buckets and adds a stash
  * @param t for emalloc
+ * @param flags any of HTABLE_STATS to record the stats printed by
+ * htable_print_stats, and HTABLE_KEYED to use a randomly seeded hash
+ * that can't be flooded with colliding words; or 0
  *
  * @return new htable
  */
-htable htable_new(int capacity, hashing_t t){
+htable htable_new(int capacity, hashing_t t, int flags){
     int i;
-    htable result = emalloc(capacity * sizeof result);
+    htable result = emalloc(sizeof *result);
     result->method = t;
+    result->probe = &strategies[t];
     result->capacity = capacity;
+    result->keyed = 0;
+    result->seed[0] = result->seed[1] = 0;
+    result->floods = 0;
+    if (flags & HTABLE_KEYED){
+        result->keyed = 1;
+        htable_reseed(result);
+    }
+    result->num_buckets = 0;
+    result->stash_used = 0;
+    result->kicks = 0;
+    result->max_kicks = 0;
+    result->kick_state = 2463534242u;
+    if (t == CUCKOO_H){
+        result->num_buckets = (capacity + CUCKOO_WAYS - 1) / CUCKOO_WAYS;
+        result->capacity = result->num_buckets * CUCKOO_WAYS + CUCKOO_STASH;
+    }
+    result->max_keys = t == QUADRATIC_P ? (capacity + 1) / 2 : result->capacity;
     result->num_keys = 0;
-    result->stats = emalloc(capacity * sizeof result->stats[0]);
-    result->keys = emalloc(result->capacity * sizeof result->keys[0]);
-    result->freqs = emalloc(result->capacity * sizeof result->freqs[0]);
-    /* initialise freqs array to avoid uninialised error */
+    result->num_tombstones = 0;
+    result->stats = NULL;
+    result->stats_len = 0;
+    result->stats_capacity = 0;
+    result->overflow_index = NULL;
+    result->overflow_value = NULL;
+    result->num_overflow = 0;
+    if (flags & HTABLE_STATS){
+        result->stats_capacity = 64;
+        result->stats = emalloc(result->stats_capacity
+                                * sizeof result->stats[0]);
+    }
+    result->slots = emalloc(result->capacity * sizeof result->slots[0]);
+    /* initialise freqs to avoid uninialised error */
     for (i=0; i<result->capacity; i++){
-        result->freqs[i] = 0;
+        result->slots[i].freq = 0;
     }
+    htable_counts_clear(&result->counters);
     return result;
 }
 
@@ -165,12 +982,41 @@ htable htable_new(int capacity, hashing_t t){
  * @param stream pointer to where information is stored
  */
 void htable_print(htable h, FILE *stream){
+    writer w = writer_new(stream);
     int i;
     for (i=0; i<h->capacity; i++){
-        if (h->freqs[i] > 0){
-            fprintf(stream, "%-5d%s\n", h->freqs[i], h->keys[i]);
+        if (h->slots[i].freq > 0){
+            writer_int(w, h->slots[i].freq, -5);
+            writer_string(w, slot_key(&h->slots[i]));
+            writer_char(w, '\n');
         }
     }
+    writer_free(w);
+}
+
+/* Calls a function on every word in the hash table and its frequency,
+ * in no particular order. The table must not be changed by f.
+ *
+ * @param h the hash table
+ * @param f the function to call
+ * @param arg passed on to f
+ */
+void htable_walk(htable h, void f(char *str, int freq, void *arg), void *arg){
+    int i;
+    for (i=0; i<h->capacity; i++){
+        if (h->slots[i].freq > 0){
+            f(slot_key(&h->slots[i]), h->slots[i].freq, arg);
+        }
+    }
+}
+
+/* Returns the number of flood alerts a hash table has raised, i.e.
+ * inserts that took suspiciously many collisions.
+ *
+ * @param h the hash table
+ */
+int htable_flood_alerts(htable h){
+    return h->floods;
 }
 
 /* Searches for a particular word in the hash table.
@@ -180,47 +1026,201 @@ void htable_print(htable h, FILE *stream){
  * @param str string to search for
  */
 int htable_search(htable ht, char *str){
-    unsigned int fhash, h, g, k;
-    int i=0;
-    for (;;){
-        k = htable_word_to_int(str);
-        if (ht->method == LINEAR_P){
-            h = k % ht->capacity;
-            fhash = (h + i) % ht->capacity;
-        }else{
-            h = k % ht->capacity;
-            g = 1 + k % (ht->capacity -1);
-            fhash = (h + (i * g)) % ht->capacity;
-        }
-        if (ht->freqs[fhash] == 0){
-            return 0; /* not here */
-        }else if (strcmp(ht->keys[fhash], str) == 0){
-            return 1; /* found */
-        }else{
-            i++;
+    return htable_search_counted(ht, str, &ht->counters);
+}
+
+/* Searches for a particular word in the hash table, recording the probe
+ * length in the given counters rather than the table's own. The table
+ * itself isn't changed, so any number of threads may search it at once
+ * as long as each has its own counters.
+ * Returns 1 if found, 0 if not
+ *
+ * @param ht htable to search in
+ * @param str string to search for
+ * @param counts counters to record the search in
+ */
+int htable_search_counted(htable ht, char *str, htable_counts counts){
+    int probes;
+    unsigned int len = strlen(str);
+    if (ht->probe->find(ht, str, htable_hash(ht, str, len), len,
+                        &probes) >= 0){
+        probe_record(counts, SEARCH_HIT, probes);
+        return 1;
+    }
+    probe_record(counts, SEARCH_MISS, probes);
+    return 0;
+}
+
+/* Puts every key from an old slot array into the table's (empty) slot
+ * array, as part of htable_compact.
+ *
+ * @param ht the htable to fill
+ * @param old_slots the slots to move the keys from
+ * @param rehash 1 to hash the keys again, 0 to reuse their saved hash
+ *
+ * @return 1 on success, 0 if a key couldn't be placed
+ */
+static int htable_place_all(htable ht, struct slot *old_slots, int rehash){
+    struct slot *s;
+    int i, pos, probes;
+    for (i=0; i<ht->capacity; i++){
+        ht->slots[i].freq = 0;
+    }
+    ht->stash_used = 0;
+    for (i=0; i<ht->capacity; i++){
+        s = &old_slots[i];
+        if (s->freq <= 0){
+            continue;
+        }
+        if (rehash){
+            s->hash = htable_hash(ht, slot_key(s), s->len);
+        }
+        pos = ht->probe->insert(ht, slot_key(s), s->hash, s->len, &probes);
+        if (pos < 0){
+            return 0;
         }
+        ht->slots[pos] = *s;
     }
-    
+    return 1;
+}
+
+/* Rehashes every key into a fresh slot array of the same capacity,
+ * dropping all tombstones. Slots are moved rather than copied, and the
+ * insertion stats are left alone since they describe how the table was
+ * built.
+ *
+ * Linear, double and quadratic probing always have room for every key,
+ * as the table never holds more keys than each key can reach. Cuckoo
+ * hashing can be unlucky when rehashing with a new seed, so it is
+ * retried with other seeds. A key is never dropped: if nothing works
+ * the program stops.
+ *
+ * @param ht the htable to compact
+ * @param rehash 0 to reuse each key's saved hash, 1 to hash the keys
+ * again because the table's hash has changed
+ */
+static void htable_compact(htable ht, int rehash){
+    struct slot *old_slots = ht->slots;
+    int attempts = 1;
+    ht->slots = emalloc(ht->capacity * sizeof ht->slots[0]);
+    while (!htable_place_all(ht, old_slots, rehash)){
+        if (!rehash || !ht->keyed || attempts++ == COMPACT_ATTEMPTS){
+            fprintf(stderr, "htable: couldn't place every key when "
+                    "compacting the table.\n");
+            exit(EXIT_FAILURE);
+        }
+        htable_reseed(ht);
+    }
+    ht->num_tombstones = 0;
+    free(old_slots);
+}
+
+/* Removes a word from the hash table, whatever its frequency. Its slot
+ * becomes a tombstone, and the table is compacted once there are too
+ * many of those.
+ *
+ * @param ht htable to delete from
+ * @param str string to delete
+ *
+ * @return 1 if the word was deleted, 0 if it wasn't in the table
+ */
+int htable_delete(htable ht, char *str){
+    int probes;
+    unsigned int len = strlen(str);
+    int pos = ht->probe->find(ht, str, htable_hash(ht, str, len), len,
+                              &probes);
+    if (pos < 0){
+        return 0;
+    }
+    slot_free_key(&ht->slots[pos]);
+    ht->num_keys--;
+    if (ht->method == CUCKOO_H){
+        /* lookups never stop early, so there's no need for a tombstone */
+        ht->slots[pos].freq = 0;
+        if (pos >= ht->num_buckets * CUCKOO_WAYS){
+            ht->stash_used--;
+        }
+        return 1;
+    }
+    ht->slots[pos].freq = TOMBSTONE;
+    ht->num_tombstones++;
+    if (ht->num_tombstones * 100 > ht->capacity * TOMBSTONE_PERCENT){
+        htable_compact(ht, 0);
+    }
+    return 1;
+}
+
+/* Decreases the frequency of a word by one, deleting it from the table
+ * when it reaches zero.
+ *
+ * @param ht htable to use
+ * @param str string to decrement
+ *
+ * @return the new frequency of the word, 0 if it is no longer in the table
+ */
+int htable_decrement(htable ht, char *str){
+    int probes;
+    unsigned int len = strlen(str);
+    int pos = ht->probe->find(ht, str, htable_hash(ht, str, len), len,
+                              &probes);
+    if (pos < 0){
+        return 0;
+    }
+    if (ht->slots[pos].freq > 1){
+        return --ht->slots[pos].freq;
+    }
+    htable_delete(ht, str);
     return 0;
 }
 
+/* Freezes the keys of a hash table into a minimal perfect hash, for
+ * when no more words will be inserted. The frozen copy only supports
+ * searching, but each search is one hash and one compare, and the index
+ * is a few bits per key for the hash plus an offset into the packed
+ * keys, rather than a mostly empty table.
+ *
+ * @param h the htable to freeze, which is left unchanged
+ *
+ * @return the frozen keys, or NULL if they couldn't be frozen
+ */
+mph htable_freeze(htable h){
+    char **keys = emalloc((h->num_keys > 0 ? h->num_keys : 1) * sizeof keys[0]);
+    mph result;
+    int i, n = 0;
+    for (i=0; i<h->capacity; i++){
+        if (h->slots[i].freq > 0){
+            keys[n++] = slot_key(&h->slots[i]);
+        }
+    }
+    result = mph_new(keys, n);
+    free(keys);
+    return result;
+}
+
 /* Prints the entire hash table.
  * Each entry is printed on a new line
  * 
  * @param h the hash table to print
  */
 void htable_print_entire_table(htable h){
+    writer w;
     int i = 0;
     printf("  Pos  Freq  Stats  Word\n");
     printf("----------------------------------------\n");
+    w = writer_new(stderr);
     for (i=0; i<h->capacity; i++){
-        if (h->keys[i] != NULL){
-            fprintf(stderr, "%5d %5d %5d   %s\n", i, h->freqs[i], h->stats[i],
-                    h->keys[i]);
-        }else{
-            fprintf(stderr, "%5d %5d %5d\n", i, h->freqs[i], h->stats[i]);
+        writer_int(w, i, 5);
+        writer_char(w, ' ');
+        writer_int(w, h->slots[i].freq, 5);
+        writer_char(w, ' ');
+        writer_int(w, stats_get(h, i), 5);
+        if (h->slots[i].freq > 0){
+            writer_string(w, "   ");
+            writer_string(w, slot_key(&h->slots[i]));
         }
+        writer_char(w, '\n');
     }
+    writer_free(w);
 }
 
 /* Prints out a line of data from the hash table to reflect the state
@@ -237,17 +1237,19 @@ static void print_stats_line(htable h, FILE *stream, int percent_full) {
     double average_collisions = 0.0;
     int at_home = 0;
     int max_collisions = 0;
+    int collisions;
     int i = 0;
     
-    if (current_entries > 0 && current_entries <= h->num_keys) {
+    if (current_entries > 0 && current_entries <= h->stats_len) {
         for (i = 0; i < current_entries; i++) {
-            if (h->stats[i] == 0) {
+            collisions = stats_get(h, i);
+            if (collisions == 0) {
                 at_home++;
             } 
-            if (h->stats[i] > max_collisions) {
-                max_collisions = h->stats[i];
+            if (collisions > max_collisions) {
+                max_collisions = collisions;
             }
-            average_collisions += h->stats[i];
+            average_collisions += collisions;
         }
         
         fprintf(stream, "%4d %10d %10.1f %10.2f %11d\n", percent_full, 
@@ -256,6 +1258,46 @@ static void print_stats_line(htable h, FILE *stream, int percent_full) {
     }
 }
 
+/* Prints the probe counts of every insert and search done on the table
+ * so far: a summary line for each kind of operation, then a histogram
+ * of how many operations needed each number of collisions.
+ *
+ * @param h the hashtable to print probe counts from
+ * @param stream the stream to send output to
+ */
+static void print_probe_counts(htable h, FILE *stream){
+    static const char *names[NUM_PROBE_OPS] = {
+        "Insert (new)", "Insert (dup)", "Search hit", "Search miss"
+    };
+    static const char *buckets[PROBE_BUCKETS] = {
+        "0", "1", "2", "3-4", "5-8", "9-16", "17-32", "33+"
+    };
+    struct probe_counter *c;
+    int i, j;
+    
+    fprintf(stream, "Operation          Count    Average    Maximum\n");
+    fprintf(stream, "-----------------------------------------------\n");
+    for (i = 0; i < NUM_PROBE_OPS; i++) {
+        c = &h->counters.op[i];
+        fprintf(stream, "%-12s %12ld %10.2f %10d\n", names[i], c->ops,
+                c->ops > 0 ? (double) c->probes / c->ops : 0.0, c->max);
+    }
+    fprintf(stream, "-----------------------------------------------\n\n");
+    fprintf(stream, "Collisions  ");
+    for (j = 0; j < PROBE_BUCKETS; j++) {
+        fprintf(stream, " %8s", buckets[j]);
+    }
+    fprintf(stream, "\n");
+    for (i = 0; i < NUM_PROBE_OPS; i++) {
+        fprintf(stream, "%-12s", names[i]);
+        for (j = 0; j < PROBE_BUCKETS; j++) {
+            fprintf(stream, " %8ld", h->counters.op[i].hist[j]);
+        }
+        fprintf(stream, "\n");
+    }
+    fprintf(stream, "\n");
+}
+
 /* Prints out a table showing what the following attributes were like
  * at regular intervals (as determined by num_stats) while the
  * hashtable was being built.
@@ -267,6 +1309,10 @@ static void print_stats_line(htable h, FILE *stream, int percent_full) {
  * @li Maximum Collisions - the most collisions that have occurred
  * while placing a key
  *
+ * The table is only filled in if h was created with HTABLE_STATS.
+ * This is followed by the probe counts of every insert and search,
+ * including duplicate inserts and failed searches.
+ *
  * @param h the hashtable to print statistics summary from
  * @param stream the stream to send output to
  * @param num_stats the maximum number of statistical snapshots to print
@@ -274,8 +1320,7 @@ static void print_stats_line(htable h, FILE *stream, int percent_full) {
 void htable_print_stats(htable h, FILE *stream, int num_stats) {
     int i;
     
-    fprintf(stream, "\n%s\n\n", 
-            h->method == LINEAR_P ? "Linear Probing" : "Double Hashing"); 
+    fprintf(stream, "\n%s\n\n", h->probe->name);
     fprintf(stream, "Percent   Current   Percent    Average      Maximum\n");
     fprintf(stream, " Full     Entries   At Home   Collisions   Collisions\n");
     fprintf(stream, "-----------------------------------------------------\n");
@@ -283,4 +1328,15 @@ void htable_print_stats(htable h, FILE *stream, int num_stats) {
         print_stats_line(h, stream, 100 * i / num_stats);
     }
     fprintf(stream, "-----------------------------------------------------\n\n");
+    if (h->keyed || h->floods > 0) {
+        fprintf(stream, "Keyed hashing : %s\n", h->keyed ? "on" : "off");
+        fprintf(stream, "Flood alerts  : %d\n\n", h->floods);
+    }
+    if (h->method == CUCKOO_H) {
+        fprintf(stream, "Kick-outs     : %ld\n", h->kicks);
+        fprintf(stream, "Max kick-outs : %d\n", h->max_kicks);
+        fprintf(stream, "Stash used    : %d of %d\n\n", h->stash_used,
+                CUCKOO_STASH);
+    }
+    print_probe_counts(h, stream);
 }
@@ -2,16 +2,33 @@
 #define HTABLE_H_
 
 #include <stdio.h>
+#include "mph.h"
 
 typedef struct htablerec *htable;
-typedef enum hashing_e { LINEAR_P, DOUBLE_H } hashing_t;
+typedef struct htable_countsrec *htable_counts;
+typedef enum hashing_e {
+    LINEAR_P, DOUBLE_H, QUADRATIC_P, CUCKOO_H
+} hashing_t;
 
+/* Flags for htable_new */
+#define HTABLE_STATS 1
+#define HTABLE_KEYED 2
+
+extern int htable_decrement(htable h, char *str);
+extern int htable_delete(htable h, char *str);
+extern int htable_flood_alerts(htable h);
 extern void htable_free(htable h);
+extern mph htable_freeze(htable h);
 extern int htable_insert(htable h, char *str);
-extern htable htable_new(int capacity, hashing_t t);
+extern htable htable_new(int capacity, hashing_t t, int flags);
 extern void htable_print(htable h, FILE *stream);
 extern int htable_search(htable h, char *str);
+extern void htable_walk(htable h, void f(char *str, int freq, void *arg),
+                        void *arg);
 extern void htable_print_entire_table(htable h);
 extern void htable_print_stats(htable h, FILE *stream, int num_stats);
+extern htable_counts htable_counts_new(void);
+extern void htable_counts_merge(htable h, htable_counts counts);
+extern int htable_search_counted(htable h, char *str, htable_counts counts);
 
 #endif
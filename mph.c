@@ -0,0 +1,269 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mph.h"
+#include "mylib.h"
+
+/* Average number of keys per bucket. Larger values make the index
+ * smaller but the build slower.
+ */
+#define MPH_LAMBDA 5
+
+/* Displacements are tried in the order d1 = 0..n-1 for each d0 up to
+ * this limit before trying another seed.
+ */
+#define MPH_MAX_D0 256
+
+/* How many seeds to try before giving up on a set of keys. */
+#define MPH_MAX_SEEDS 16
+
+/* A minimal perfect hash over a fixed set of keys, built with the CHD
+ * (compress, hash and displace) algorithm. Every key hashes to a bucket,
+ * and each bucket has a displacement that sends its keys to distinct
+ * positions 0..n-1. The keys are kept in one packed blob in position
+ * order, so a lookup is one hash, one displacement and one compare.
+ */
+struct mphrec {
+    int n;
+    int num_buckets;
+    unsigned int seed;
+    unsigned int *disp;
+    unsigned int *offsets;
+    char *blob;
+};
+
+/* Hashes a key in a single pass, giving its bucket and the two values
+ * that, with the bucket's displacement, give its position. Two separate
+ * 32 bit accumulators are used so that keys only collide completely if
+ * 64 bits of hash match.
+ *
+ * @param m the mph (for the seed and sizes)
+ * @param str the key to hash
+ * @param g set to the key's bucket
+ * @param f1 set to the key's base position
+ * @param f2 set to the key's position step
+ */
+static void mph_hash(mph m, char *str, unsigned int *g, unsigned int *f1,
+                     unsigned int *f2){
+    unsigned int x = 2166136261u ^ m->seed;
+    unsigned int y = m->seed * 0x9e3779b9u + 1;
+    unsigned int c;
+    while (*str != '\0'){
+        c = (unsigned char) *str++;
+        x = ((x ^ c) * 16777619u) & 0xffffffffu;
+        y = ((y + c) * 0x5bd1e995u) & 0xffffffffu;
+        y ^= y >> 15;
+    }
+    x = hash_mix(x);
+    y = hash_mix(y);
+    *g = x % m->num_buckets;
+    *f1 = y % m->n;
+    *f2 = hash_mix(x ^ y) % m->n;
+}
+
+/* Returns the position a displacement gives a key.
+ *
+ * @param m the mph
+ * @param disp the displacement of the key's bucket
+ * @param f1 the key's base position
+ * @param f2 the key's position step
+ */
+static unsigned int mph_position(mph m, unsigned int disp, unsigned int f1,
+                                 unsigned int f2){
+    unsigned long d0 = disp / m->n;
+    unsigned long d1 = disp % m->n;
+    return (f1 + (d0 * f2) % m->n + d1) % m->n;
+}
+
+/* Tries to find a displacement for every bucket with the current seed.
+ *
+ * @param m the mph to fill in the displacements of
+ * @param keys the keys
+ * @param pos set to the position of each key
+ *
+ * @return 1 on success, 0 if some bucket couldn't be placed
+ */
+static int mph_place(mph m, char **keys, unsigned int *pos){
+    unsigned int *g = emalloc(m->n * sizeof g[0]);
+    unsigned int *f1 = emalloc(m->n * sizeof f1[0]);
+    unsigned int *f2 = emalloc(m->n * sizeof f2[0]);
+    int *start = emalloc((m->num_buckets + 1) * sizeof start[0]);
+    int *next = emalloc(m->num_buckets * sizeof next[0]);
+    int *members = emalloc(m->n * sizeof members[0]);
+    int *order = emalloc(m->num_buckets * sizeof order[0]);
+    int *count;
+    char *taken = emalloc(m->n * sizeof taken[0]);
+    unsigned int max_disp, disp;
+    int *key;
+    int i, j, b, size, total, max_size = 0, ok = 1;
+
+    /* group the keys by bucket, so that bucket b's keys are
+       members[start[b]] .. members[start[b + 1] - 1] */
+    for (b = 0; b <= m->num_buckets; b++){
+        start[b] = 0;
+    }
+    for (i = 0; i < m->n; i++){
+        mph_hash(m, keys[i], &g[i], &f1[i], &f2[i]);
+        start[g[i] + 1]++;
+        taken[i] = 0;
+    }
+    for (b = 0; b < m->num_buckets; b++){
+        if (start[b + 1] > max_size){
+            max_size = start[b + 1];
+        }
+        start[b + 1] += start[b];
+        next[b] = start[b];
+    }
+    for (i = 0; i < m->n; i++){
+        members[next[g[i]]++] = i;
+    }
+
+    /* place the largest buckets first, since they are the hardest */
+    count = emalloc((max_size + 1) * sizeof count[0]);
+    for (j = 0; j <= max_size; j++){
+        count[j] = 0;
+    }
+    for (b = 0; b < m->num_buckets; b++){
+        count[start[b + 1] - start[b]]++;
+    }
+    for (j = max_size, total = 0; j >= 0; j--){
+        size = count[j];
+        count[j] = total;
+        total += size;
+    }
+    for (b = 0; b < m->num_buckets; b++){
+        order[count[start[b + 1] - start[b]]++] = b;
+    }
+
+    max_disp = 0xffffffffu / m->n > MPH_MAX_D0 ? (unsigned int) m->n * MPH_MAX_D0
+        : 0xffffffffu - 0xffffffffu % m->n;
+    for (j = 0; j < m->num_buckets && ok; j++){
+        b = order[j];
+        size = start[b + 1] - start[b];
+        key = members + start[b];
+        m->disp[b] = 0;
+        if (size == 0){
+            continue;
+        }
+        for (disp = 0; disp < max_disp; disp++){
+            for (i = 0; i < size; i++){
+                pos[key[i]] = mph_position(m, disp, f1[key[i]], f2[key[i]]);
+                if (taken[pos[key[i]]]){
+                    break;
+                }
+                taken[pos[key[i]]] = 1;
+            }
+            if (i == size){
+                m->disp[b] = disp;
+                break;
+            }
+            while (--i >= 0){ /* undo, the bucket's keys clashed */
+                taken[pos[key[i]]] = 0;
+            }
+        }
+        if (disp == max_disp){
+            ok = 0;
+        }
+    }
+    free(g);
+    free(f1);
+    free(f2);
+    free(start);
+    free(next);
+    free(members);
+    free(order);
+    free(count);
+    free(taken);
+    return ok;
+}
+
+/* Builds a minimal perfect hash over a set of distinct keys. The keys
+ * are copied, so the caller may free them afterwards.
+ *
+ * @param keys the keys
+ * @param n number of keys
+ *
+ * @return new mph, or NULL if one couldn't be built
+ */
+mph mph_new(char **keys, int n){
+    mph result = emalloc(sizeof *result);
+    unsigned int *pos = emalloc((n > 0 ? n : 1) * sizeof pos[0]);
+    unsigned int len = 0;
+    int i, seed;
+    result->n = n;
+    result->num_buckets = n / MPH_LAMBDA + 1;
+    result->disp = emalloc(result->num_buckets * sizeof result->disp[0]);
+    for (seed = 0; n > 0 && seed < MPH_MAX_SEEDS; seed++){
+        result->seed = seed;
+        if (mph_place(result, keys, pos)){
+            break;
+        }
+    }
+    if (seed == MPH_MAX_SEEDS){
+        free(pos);
+        free(result->disp);
+        free(result);
+        return NULL;
+    }
+    result->offsets = emalloc((n + 1) * sizeof result->offsets[0]);
+    for (i = 0; i < n; i++){
+        result->offsets[pos[i]] = strlen(keys[i]) + 1;
+    }
+    for (i = 0; i < n; i++){ /* lengths to offsets */
+        len += result->offsets[i];
+        result->offsets[i] = len - result->offsets[i];
+    }
+    result->offsets[n] = len;
+    result->blob = emalloc(len + 1);
+    for (i = 0; i < n; i++){
+        strcpy(result->blob + result->offsets[pos[i]], keys[i]);
+    }
+    free(pos);
+    return result;
+}
+
+/* Frees an mph from memory.
+ *
+ * @param m the mph to free
+ */
+void mph_free(mph m){
+    free(m->disp);
+    free(m->offsets);
+    free(m->blob);
+    free(m);
+}
+
+/* Searches for a key.
+ * Returns 1 if found, 0 if not
+ *
+ * @param m the mph to search in
+ * @param str the key to search for
+ */
+int mph_search(mph m, char *str){
+    unsigned int g, f1, f2, pos;
+    if (m->n == 0){
+        return 0;
+    }
+    mph_hash(m, str, &g, &f1, &f2);
+    pos = mph_position(m, m->disp[g], f1, f2);
+    return strcmp(m->blob + m->offsets[pos], str) == 0;
+}
+
+/* Returns the size of the index, in bits: the displacements, plus the
+ * offsets every search needs to find its key in the blob. The packed
+ * keys themselves aren't counted.
+ *
+ * @param m the mph
+ */
+long mph_index_bits(mph m){
+    return ((long) m->num_buckets * sizeof m->disp[0]
+            + (long) (m->n + 1) * sizeof m->offsets[0]) * 8;
+}
+
+/* Returns the number of keys in the mph.
+ *
+ * @param m the mph
+ */
+int mph_num_keys(mph m){
+    return m->n;
+}
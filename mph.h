@@ -0,0 +1,12 @@
+#ifndef MPH_H_
+#define MPH_H_
+
+typedef struct mphrec *mph;
+
+extern mph mph_new(char **keys, int n);
+extern void mph_free(mph m);
+extern int mph_search(mph m, char *str);
+extern long mph_index_bits(mph m);
+extern int mph_num_keys(mph m);
+
+#endif
@@ -1,8 +1,10 @@
+#define _POSIX_C_SOURCE 200112L
 #include <stdio.h>
 #include <stdlib.h>
 #include "mylib.h"
 #include <ctype.h>
 #include <assert.h>
+#include <time.h>
 
 #define DEFAULT_TABLE_SIZE 113
 
@@ -38,6 +40,47 @@ int getword(char *s, int limit, FILE *stream){
     return w-s;
 }
 
+/* Getword function to read words from a block of memory. Splits the
+ * text into the same words as getword would if it were read from a file.
+ *
+ * @param s word read from the text
+ * @param limit to number of words
+ * @param pos where to start reading, moved past the word that was read
+ * @param end the end of the text
+ *
+ * @return word that can be read as a string
+ */
+int sgetword(char *s, int limit, char **pos, char *end){
+    int c;
+    char *w = s;
+    char *p = *pos;
+    assert(limit > 0 && s != NULL && pos != NULL && end != NULL);
+    
+    while (p < end && !isalnum((unsigned char) *p)){
+        p++;
+    }
+    if (p == end){
+        *pos = p;
+        return EOF;
+    }else if (--limit > 0) {
+        *w++ = tolower((unsigned char) *p);
+    }
+    p++;
+    while (--limit > 0 && p < end){
+        c = (unsigned char) *p++;
+        if (isalnum(c)){
+            *w++ = tolower(c);
+        }else if ('\'' == c){
+            limit++;
+        }else{
+            break;
+        }
+    }
+    *w = '\0';
+    *pos = p;
+    return w-s;
+}
+
 /* Determines if a number is prime.
  *
  * @param p the number to be checked
@@ -84,25 +127,47 @@ int table_size(int s){
  * @param prog_name char pointer to the name of our program
  */
 void print_help(char *prog_name){
-    printf("Usage: %s [OPTIONS]... <STDIN>\n", prog_name);
+    printf("Usage: %s [OPTIONS]... [FILE]... <STDIN>\n", prog_name);
     printf("\n");
     printf("Perform tasks using a hash table or binary tree.  By default, ");
     printf("words\n");
-    printf("read from stdin are added to the data structure before printing\n");
+    printf("read from stdin, or from the FILEs given (a directory means every\n");
+    printf("file in it), are added to the data structure before printing\n");
     printf("them, along with their frequencies, to stdout.\n");
     printf("\n");
     printf("-T           Use tree data structure (default is hash table)\n");
+    printf("-b           Use bucketized cuckoo hashing (linear probing is\n");
+    printf("             default)\n");
     printf("-c FILENAME  Check spelling of words in FILENAME using words\n");
     printf("             from stdin as dictionary. Print unknown words to\n");
-    printf("             stdout, timing info etc to stderr (ignore -o & -p)\n"); 
+    printf("             stdout, timing info etc to stderr (ignore -o, and\n");
+    printf("             -p prints stats after the search)\n");
     printf("-d           Use double hashing (linear probing is default)\n");
     printf("-e           Display entire contents of hash table on stderr\n");
+    printf("-f           Freeze the hash table into a minimal perfect hash\n");
+    printf("             before checking spelling (if -c is used)\n");
+    printf("-g           Suggest up to 5 corrections for each unknown word,\n");
+    printf("             printed after it (if -c is used)\n");
+    printf("-j THREADS   Check spelling using THREADS threads (if -c is used)\n");
+    printf("-k           Use a randomly keyed hash for the hash table, so it\n");
+    printf("             can't be flooded with colliding words\n");
+    printf("-m           Merge the snapshots in the FILEs given (or stdin),\n");
+    printf("             printing the combined frequencies & words in order\n");
     printf("-o           Output the tree in DOT form to file 'tree-view.dot'\n");
     printf("-p           Print hash table stats instead of frequencies & words");
     printf("\n");
+    printf("-q           Use quadratic probing (linear probing is default),\n");
+    printf("             which only fills up to half of the table\n");
     printf("-r           Make the tree an RBT (the default is a BST)\n");
     printf("-s SNAPSHOTS Show SNAPSHOTS stats snapshots (if -p is used)\n");
     printf("-t TABLESIZE Use the first prime >= TABLESIZE as htable size\n");
+    printf("-u           Estimate the number of distinct words using constant\n");
+    printf("             memory. Reads any FILEs given after the options\n");
+    printf("             instead of stdin, merging estimators saved with -w\n");
+    printf("-w FILENAME  Save a binary snapshot of the words & frequencies to\n");
+    printf("             FILENAME instead of printing them (with -m, save\n");
+    printf("             the merged snapshot; with -u, save the distinct\n");
+    printf("             word estimator)\n");
     printf("\n");
     printf("-h           Display this message\n");
     printf("\n");
@@ -134,3 +199,29 @@ void *erealloc(void *p, size_t s){
     }
     return result;
 }
+
+/* Returns the current wall clock time in seconds.
+ *
+ * @return seconds since an arbitrary fixed point
+ */
+double wall_time(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* The murmur3 finaliser. Mixes every bit of a hash into every other,
+ * so that any bits of the result can be used on their own.
+ *
+ * @param h the hash to mix
+ *
+ * @return the mixed hash
+ */
+unsigned int hash_mix(unsigned int h){
+    h ^= h >> 16;
+    h = (h * 0x85ebca6bu) & 0xffffffffu;
+    h ^= h >> 13;
+    h = (h * 0xc2b2ae35u) & 0xffffffffu;
+    h ^= h >> 16;
+    return h;
+}
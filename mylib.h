@@ -6,8 +6,11 @@
 extern void *emalloc(size_t);
 extern void *erealloc(void *, size_t);
 extern int getword(char *s, int limit, FILE *stream);
+extern int sgetword(char *s, int limit, char **pos, char *end);
 extern void print_help();
 extern int find_greater_prime(int n);
 extern int table_size(int s);
+extern double wall_time(void);
+extern unsigned int hash_mix(unsigned int h);
 
 #endif
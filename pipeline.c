@@ -0,0 +1,328 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "pipeline.h"
+#include "queue.h"
+#include "mylib.h"
+
+/* Size of each read, and how many reads may be waiting to be
+ * tokenized. Both counts must be powers of two, as they size queues.
+ */
+#define READ_SIZE 262144
+#define READ_AHEAD 8
+#define NUM_BATCHES 8
+
+/* A block of raw input. end_of_file marks the (empty) block read at the
+ * end of each file, and done the block sent after the last file.
+ */
+struct read_block {
+    int len;
+    int end_of_file;
+    int done;
+    char data[READ_SIZE];
+};
+
+/* Reads words from files in three stages, each on its own thread: a
+ * reader that keeps up to READ_AHEAD blocks of input read ahead, a
+ * tokenizer that splits the blocks into batches of words, and the
+ * caller, which takes the batches with pipeline_next. The stages are
+ * connected by single producer, single consumer queues, with blocks and
+ * batches handed back through free queues so nothing is allocated once
+ * the pipeline is running.
+ */
+struct pipelinerec {
+    char **paths;
+    int num_paths;
+    struct read_block *blocks;
+    struct word_batch *batches;
+    queue free_blocks;
+    queue full_blocks;
+    queue free_batches;
+    queue full_batches;
+    pthread_t reader;
+    pthread_t tokenizer;
+};
+
+/* Adds a copy of a path to the pipeline's list of files.
+ *
+ * @param p the pipeline
+ * @param path the path to add
+ */
+static void add_path(pipeline p, char *path){
+    p->paths = erealloc(p->paths, (p->num_paths + 1) * sizeof p->paths[0]);
+    p->paths[p->num_paths] = emalloc(strlen(path) + 1);
+    strcpy(p->paths[p->num_paths], path);
+    p->num_paths++;
+}
+
+/* Compares two strings for qsort. */
+static int compare_paths(const void *a, const void *b){
+    return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+/* Adds a path to the pipeline's list of files, or if it's a directory,
+ * every file in it and its subdirectories, in name order. Hidden files
+ * are skipped.
+ *
+ * @param p the pipeline
+ * @param path the file or directory to add
+ *
+ * @return 1 on success, 0 if a file or directory can't be read
+ */
+static int expand_path(pipeline p, char *path){
+    struct stat st;
+    struct dirent *entry;
+    DIR *dir;
+    FILE *test;
+    char **names = NULL;
+    char *full;
+    int num_names = 0;
+    int i, ok = 1;
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)){
+        if (NULL == (dir = opendir(path))){
+            fprintf(stderr, "Can't open directory '%s'.\n", path);
+            return 0;
+        }
+        while ((entry = readdir(dir)) != NULL){
+            if (entry->d_name[0] == '.'){
+                continue;
+            }
+            full = emalloc(strlen(path) + strlen(entry->d_name) + 2);
+            sprintf(full, "%s/%s", path, entry->d_name);
+            names = erealloc(names, (num_names + 1) * sizeof names[0]);
+            names[num_names++] = full;
+        }
+        closedir(dir);
+        qsort(names, num_names, sizeof names[0], compare_paths);
+        for (i = 0; i < num_names; i++){
+            ok = ok && expand_path(p, names[i]);
+            free(names[i]);
+        }
+        free(names);
+        return ok;
+    }
+    if (NULL == (test = fopen(path, "r"))){
+        fprintf(stderr, "Can't open file '%s' using mode r.\n", path);
+        return 0;
+    }
+    fclose(test);
+    add_path(p, path);
+    return 1;
+}
+
+/* Reads every file into blocks, in order, for the tokenizer.
+ *
+ * @param arg the pipeline
+ *
+ * @return NULL
+ */
+static void *reader_stage(void *arg){
+    pipeline p = arg;
+    struct read_block *b;
+    ssize_t n;
+    int i, fd;
+    for (i = 0; i < p->num_paths || (i == 0 && p->num_paths == 0); i++){
+        if (p->num_paths == 0){
+            fd = STDIN_FILENO;
+        }else if ((fd = open(p->paths[i], O_RDONLY)) < 0){
+            fprintf(stderr, "Can't open file '%s' using mode r.\n",
+                    p->paths[i]);
+            continue;
+        }else{
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+        do {
+            b = queue_pop(p->free_blocks);
+            while ((n = read(fd, b->data, READ_SIZE)) < 0 && errno == EINTR){
+                ;
+            }
+            b->len = n > 0 ? n : 0;
+            b->end_of_file = n <= 0;
+            b->done = 0;
+            queue_push(p->full_blocks, b);
+        } while (n > 0);
+        if (fd != STDIN_FILENO){
+            close(fd);
+        }
+    }
+    b = queue_pop(p->free_blocks);
+    b->len = 0;
+    b->end_of_file = 1;
+    b->done = 1;
+    queue_push(p->full_blocks, b);
+    return NULL;
+}
+
+/* Adds a word to a batch, sending the batch on first if it is full.
+ *
+ * @param p the pipeline
+ * @param batch the batch to add to
+ * @param word the word to add
+ * @param len the length of the word
+ *
+ * @return the batch the word was added to
+ */
+static struct word_batch *batch_add(pipeline p, struct word_batch *batch,
+                                    char *word, int len){
+    if (batch->len + len + 1 > BATCH_SIZE){
+        queue_push(p->full_batches, batch);
+        batch = queue_pop(p->free_batches);
+        batch->count = 0;
+        batch->len = 0;
+    }
+    memcpy(batch->words + batch->len, word, len);
+    batch->len += len;
+    batch->words[batch->len++] = '\0';
+    batch->count++;
+    return batch;
+}
+
+/* Splits the blocks of input into words, exactly as getword would if
+ * each file were read with it, and sends them on in batches. A NULL
+ * batch marks the end of the input.
+ *
+ * @param arg the pipeline
+ *
+ * @return NULL
+ */
+static void *tokenizer_stage(void *arg){
+    pipeline p = arg;
+    struct word_batch *batch = queue_pop(p->free_batches);
+    struct read_block *b;
+    char word[256];
+    int len = 0, limit = 0, in_word = 0;
+    int i, c;
+    batch->count = 0;
+    batch->len = 0;
+    for (b = queue_pop(p->full_blocks); !b->done; b = queue_pop(p->full_blocks)){
+        for (i = 0; i < b->len; i++){
+            c = (unsigned char) b->data[i];
+            if (in_word){
+                if (--limit > 0){
+                    if (isalnum(c)){
+                        word[len++] = tolower(c);
+                        continue;
+                    }else if ('\'' == c){
+                        limit++;
+                        continue;
+                    }
+                }
+                /* the word ended; if it was cut short by the limit then
+                   c still needs looking at */
+                batch = batch_add(p, batch, word, len);
+                in_word = 0;
+            }
+            if (isalnum(c)){
+                word[0] = tolower(c);
+                len = 1;
+                limit = sizeof word - 1;
+                in_word = 1;
+            }
+        }
+        if (b->end_of_file && in_word){
+            batch = batch_add(p, batch, word, len);
+            in_word = 0;
+        }
+        queue_push(p->free_blocks, b);
+    }
+    if (batch->count > 0){
+        queue_push(p->full_batches, batch);
+    }
+    queue_push(p->full_batches, NULL);
+    return NULL;
+}
+
+/* Starts reading words from a list of files, or stdin if there are
+ * none. Directories are replaced by the files inside them.
+ *
+ * @param paths the files and directories to read
+ * @param num_paths number of paths
+ *
+ * @return new pipeline, or NULL if a file can't be read
+ */
+pipeline pipeline_new(char **paths, int num_paths){
+    pipeline result = emalloc(sizeof *result);
+    int i;
+    result->paths = NULL;
+    result->num_paths = 0;
+    for (i = 0; i < num_paths; i++){
+        if (!expand_path(result, paths[i])){
+            for (i = 0; i < result->num_paths; i++){
+                free(result->paths[i]);
+            }
+            free(result->paths);
+            free(result);
+            return NULL;
+        }
+    }
+    result->blocks = emalloc(READ_AHEAD * sizeof result->blocks[0]);
+    result->batches = emalloc(NUM_BATCHES * sizeof result->batches[0]);
+    result->free_blocks = queue_new(READ_AHEAD);
+    result->full_blocks = queue_new(READ_AHEAD);
+    result->free_batches = queue_new(NUM_BATCHES);
+    result->full_batches = queue_new(2 * NUM_BATCHES); /* room for the NULL */
+    for (i = 0; i < READ_AHEAD; i++){
+        queue_push(result->free_blocks, &result->blocks[i]);
+    }
+    for (i = 0; i < NUM_BATCHES; i++){
+        queue_push(result->free_batches, &result->batches[i]);
+    }
+    if (pthread_create(&result->reader, NULL, reader_stage, result) != 0
+        || pthread_create(&result->tokenizer, NULL, tokenizer_stage,
+                          result) != 0){
+        fprintf(stderr, "thread creation failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    return result;
+}
+
+/* Returns the next batch of words, waiting for it if necessary. It must
+ * be handed back with pipeline_release once the words have been used.
+ *
+ * @param p the pipeline
+ *
+ * @return the next batch, or NULL once all the words have been read
+ */
+struct word_batch *pipeline_next(pipeline p){
+    return queue_pop(p->full_batches);
+}
+
+/* Hands a batch back to the pipeline for reuse.
+ *
+ * @param p the pipeline
+ * @param batch a batch returned by pipeline_next
+ */
+void pipeline_release(pipeline p, struct word_batch *batch){
+    queue_push(p->free_batches, batch);
+}
+
+/* Waits for the pipeline's threads to finish and frees it. This should
+ * only be called after pipeline_next has returned NULL.
+ *
+ * @param p the pipeline to free
+ */
+void pipeline_free(pipeline p){
+    int i;
+    pthread_join(p->reader, NULL);
+    pthread_join(p->tokenizer, NULL);
+    for (i = 0; i < p->num_paths; i++){
+        free(p->paths[i]);
+    }
+    free(p->paths);
+    free(p->blocks);
+    free(p->batches);
+    queue_free(p->free_blocks);
+    queue_free(p->full_blocks);
+    queue_free(p->free_batches);
+    queue_free(p->full_batches);
+    free(p);
+}
@@ -0,0 +1,23 @@
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+/* Room for the words in a batch. */
+#define BATCH_SIZE 65536
+
+/* A batch of words read by a pipeline. The words are stored one after
+ * another in words, each followed by a '\0'.
+ */
+struct word_batch {
+    int count;
+    int len;
+    char words[BATCH_SIZE];
+};
+
+typedef struct pipelinerec *pipeline;
+
+extern pipeline pipeline_new(char **paths, int num_paths);
+extern struct word_batch *pipeline_next(pipeline p);
+extern void pipeline_release(pipeline p, struct word_batch *batch);
+extern void pipeline_free(pipeline p);
+
+#endif
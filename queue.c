@@ -0,0 +1,84 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "queue.h"
+#include "mylib.h"
+
+/* Assumed size of a cache line, used to keep the two ends of a queue
+ * from sharing one.
+ */
+#define CACHE_LINE 64
+
+/* A bounded, lock-free queue of pointers for exactly one producer
+ * thread and one consumer thread. The producer only writes tail and
+ * the consumer only writes head; each reads the other's with acquire
+ * ordering, so the item stored before a tail update is always visible
+ * to the consumer that sees it.
+ */
+struct queuerec {
+    unsigned int head;
+    char pad1[CACHE_LINE - sizeof(unsigned int)];
+    unsigned int tail;
+    char pad2[CACHE_LINE - sizeof(unsigned int)];
+    unsigned int mask;
+    void **items;
+};
+
+/* Creates a new, empty queue.
+ *
+ * @param capacity the most items the queue can hold, which must be a
+ * power of two
+ *
+ * @return new queue
+ */
+queue queue_new(int capacity){
+    queue result = emalloc(sizeof *result);
+    result->head = 0;
+    result->tail = 0;
+    result->mask = capacity - 1;
+    result->items = emalloc(capacity * sizeof result->items[0]);
+    return result;
+}
+
+/* Frees a queue from memory. Any items still in it are not freed.
+ *
+ * @param q the queue to free
+ */
+void queue_free(queue q){
+    free(q->items);
+    free(q);
+}
+
+/* Adds an item to the back of the queue, waiting for room if it is full.
+ * Only one thread may push to a queue.
+ *
+ * @param q the queue to add to
+ * @param item the item to add
+ */
+void queue_push(queue q, void *item){
+    unsigned int tail = q->tail;
+    while (tail - __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) > q->mask){
+        sched_yield();
+    }
+    q->items[tail & q->mask] = item;
+    __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/* Removes the item at the front of the queue, waiting for one if it is
+ * empty. Only one thread may pop from a queue.
+ *
+ * @param q the queue to remove from
+ *
+ * @return the item
+ */
+void *queue_pop(queue q){
+    unsigned int head = q->head;
+    void *item;
+    while (__atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) == head){
+        sched_yield();
+    }
+    item = q->items[head & q->mask];
+    __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+    return item;
+}
@@ -0,0 +1,11 @@
+#ifndef QUEUE_H_
+#define QUEUE_H_
+
+typedef struct queuerec *queue;
+
+extern queue queue_new(int capacity);
+extern void queue_free(queue q);
+extern void queue_push(queue q, void *item);
+extern void *queue_pop(queue q);
+
+#endif
@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+#include "mylib.h"
+
+/* A snapshot is SNAPSHOT_MAGIC followed by one record per key, in
+ * strcmp order, and a terminating record. Keys are front coded: each
+ * record holds the length of the prefix shared with the previous key,
+ * the length of the rest of the key, the rest of the key and the
+ * frequency, with the numbers stored as varints (seven bits per byte,
+ * low bits first, high bit set on all but the last byte). Since keys
+ * are unique and sorted, only the terminator has an empty suffix.
+ */
+#define SNAPSHOT_MAGIC "WCS1"
+
+struct snapshot_writerrec {
+    FILE *stream;
+    char *prev;
+    int prev_len;
+    int prev_capacity;
+};
+
+struct snapshot_readerrec {
+    FILE *stream;
+    char *key;
+    int key_len;
+    int key_capacity;
+};
+
+/* A reader taking part in a merge, and its current key. */
+struct merge_input {
+    snapshot_reader reader;
+    char *key;
+    int freq;
+};
+
+/* A word and frequency collected from a hash table for sorting. */
+struct entry {
+    char *key;
+    int freq;
+};
+
+/* Writes a number as a varint.
+ *
+ * @param n the number to write
+ * @param stream the stream to write to
+ */
+static void put_varint(unsigned int n, FILE *stream){
+    while (n >= 0x80){
+        putc((int) (n & 0x7f) | 0x80, stream);
+        n >>= 7;
+    }
+    putc((int) n, stream);
+}
+
+/* Reads a number written by put_varint.
+ *
+ * @param n where to store the number
+ * @param stream the stream to read from
+ *
+ * @return 1 on success, 0 at end of file or if the number is too long
+ */
+static int get_varint(unsigned int *n, FILE *stream){
+    int c, shift;
+    *n = 0;
+    for (shift = 0; shift < 32; shift += 7){
+        if ((c = getc(stream)) == EOF){
+            return 0;
+        }
+        *n |= (unsigned int) (c & 0x7f) << shift;
+        if (!(c & 0x80)){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Starts writing a snapshot to a stream.
+ *
+ * @param stream the stream to write to, opened in binary mode
+ *
+ * @return new snapshot writer
+ */
+snapshot_writer snapshot_writer_new(FILE *stream){
+    snapshot_writer result = emalloc(sizeof *result);
+    result->stream = stream;
+    result->prev_capacity = 256;
+    result->prev = emalloc(result->prev_capacity);
+    result->prev_len = 0;
+    fwrite(SNAPSHOT_MAGIC, 1, strlen(SNAPSHOT_MAGIC), stream);
+    return result;
+}
+
+/* Adds a key to a snapshot. Keys must be added in strcmp order, each
+ * key only once.
+ *
+ * @param s the snapshot writer
+ * @param key the key to add
+ * @param freq the frequency of the key
+ */
+void snapshot_writer_add(snapshot_writer s, char *key, int freq){
+    int len = strlen(key);
+    int prefix = 0;
+    while (prefix < s->prev_len && prefix < len
+           && s->prev[prefix] == key[prefix]){
+        prefix++;
+    }
+    put_varint(prefix, s->stream);
+    put_varint(len - prefix, s->stream);
+    fwrite(key + prefix, 1, len - prefix, s->stream);
+    put_varint(freq, s->stream);
+    if (len > s->prev_capacity){
+        s->prev_capacity = len;
+        s->prev = erealloc(s->prev, s->prev_capacity);
+    }
+    memcpy(s->prev, key, len);
+    s->prev_len = len;
+}
+
+/* Finishes a snapshot and frees the writer. The stream is left open.
+ *
+ * @param s the snapshot writer to free
+ */
+void snapshot_writer_free(snapshot_writer s){
+    put_varint(0, s->stream);
+    put_varint(0, s->stream);
+    free(s->prev);
+    free(s);
+}
+
+/* Starts reading a snapshot from a stream.
+ *
+ * @param stream the stream to read from, opened in binary mode
+ *
+ * @return new snapshot reader, or NULL if the stream isn't a snapshot
+ */
+snapshot_reader snapshot_reader_new(FILE *stream){
+    snapshot_reader result;
+    char magic[5];
+    magic[4] = '\0';
+    if (fread(magic, 1, 4, stream) != 4 || strcmp(magic, SNAPSHOT_MAGIC) != 0){
+        return NULL;
+    }
+    result = emalloc(sizeof *result);
+    result->stream = stream;
+    result->key_capacity = 256;
+    result->key = emalloc(result->key_capacity);
+    result->key[0] = '\0';
+    result->key_len = 0;
+    return result;
+}
+
+/* Reads the next key from a snapshot. The key is only valid until the
+ * next call.
+ *
+ * @param s the snapshot reader
+ * @param key where to store the key
+ * @param freq where to store the frequency of the key
+ *
+ * @return 1 if a key was read, 0 at the end of the snapshot, or -1 if
+ * the snapshot is corrupt or out of order
+ */
+int snapshot_reader_next(snapshot_reader s, char **key, int *freq){
+    unsigned int prefix, suffix, n;
+    int replaced;
+    if (!get_varint(&prefix, s->stream) || !get_varint(&suffix, s->stream)){
+        return -1;
+    }
+    if (suffix == 0){
+        return prefix == 0 ? 0 : -1;
+    }
+    if (prefix > (unsigned int) s->key_len){
+        return -1;
+    }
+    if (prefix + suffix + 1 > (unsigned int) s->key_capacity){
+        s->key_capacity = prefix + suffix + 1;
+        s->key = erealloc(s->key, s->key_capacity);
+    }
+    /* the first new character must sort after the one it replaces */
+    replaced = prefix < (unsigned int) s->key_len ?
+        (unsigned char) s->key[prefix] : -1;
+    if (fread(s->key + prefix, 1, suffix, s->stream) != suffix
+        || !get_varint(&n, s->stream)
+        || (unsigned char) s->key[prefix] <= replaced){
+        return -1;
+    }
+    s->key_len = prefix + suffix;
+    s->key[s->key_len] = '\0';
+    *key = s->key;
+    *freq = (int) n;
+    return 1;
+}
+
+/* Frees a snapshot reader. The stream is left open.
+ *
+ * @param s the snapshot reader to free
+ */
+void snapshot_reader_free(snapshot_reader s){
+    free(s->key);
+    free(s);
+}
+
+/* Counts the words in a hash table. */
+static void count_entry(char *key, int freq, void *arg){
+    (*(int *) arg)++;
+    (void) key;
+    (void) freq;
+}
+
+/* Adds a word and its frequency to an array of entries. */
+static void collect_entry(char *key, int freq, void *arg){
+    struct entry **next = arg;
+    (*next)->key = key;
+    (*next)->freq = freq;
+    (*next)++;
+}
+
+/* Compares two entries by key for qsort. */
+static int compare_entries(const void *a, const void *b){
+    return strcmp(((const struct entry *) a)->key,
+                  ((const struct entry *) b)->key);
+}
+
+/* Adds a word and its frequency to a snapshot. */
+static void write_entry(char *key, int freq, void *arg){
+    snapshot_writer_add(arg, key, freq);
+}
+
+/* Writes a snapshot of the words in a hash table and their frequencies.
+ *
+ * @param h the hash table
+ * @param stream the stream to write to, opened in binary mode
+ */
+void snapshot_save_htable(htable h, FILE *stream){
+    struct entry *entries, *next;
+    snapshot_writer s = snapshot_writer_new(stream);
+    int i, n;
+    n = 0;
+    htable_walk(h, count_entry, &n);
+    entries = emalloc((n > 0 ? n : 1) * sizeof entries[0]);
+    next = entries;
+    htable_walk(h, collect_entry, &next);
+    qsort(entries, n, sizeof entries[0], compare_entries);
+    for (i = 0; i < n; i++){
+        snapshot_writer_add(s, entries[i].key, entries[i].freq);
+    }
+    snapshot_writer_free(s);
+    free(entries);
+}
+
+/* Writes a snapshot of the words in a tree and their frequencies.
+ *
+ * @param b the tree
+ * @param stream the stream to write to, opened in binary mode
+ */
+void snapshot_save_tree(tree b, FILE *stream){
+    snapshot_writer s = snapshot_writer_new(stream);
+    tree_walk(b, write_entry, s);
+    snapshot_writer_free(s);
+}
+
+/* Compares the current keys of two merge inputs. */
+static int input_less(struct merge_input *a, struct merge_input *b){
+    return strcmp(a->key, b->key) < 0;
+}
+
+/* Moves the input at position i of a heap down until neither of its
+ * children has a smaller key.
+ *
+ * @param heap the heap
+ * @param n number of inputs in the heap
+ * @param i position of the input to move
+ */
+static void sift_down(struct merge_input *heap, int n, int i){
+    struct merge_input tmp;
+    int child;
+    while ((child = 2 * i + 1) < n){
+        if (child + 1 < n && input_less(&heap[child + 1], &heap[child])){
+            child++;
+        }
+        if (!input_less(&heap[child], &heap[i])){
+            break;
+        }
+        tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+}
+
+/* Merges several snapshots, calling a function on each distinct key in
+ * strcmp order with the sum of its frequencies. Only the current key of
+ * each snapshot is held in memory, in a heap ordered by key.
+ *
+ * @param inputs the snapshots to merge
+ * @param n number of snapshots
+ * @param f the function to call on each key
+ * @param arg passed on to f
+ *
+ * @return 1 on success, 0 if a snapshot is corrupt
+ */
+int snapshot_merge(snapshot_reader *inputs, int n,
+                   void f(char *key, int freq, void *arg), void *arg){
+    struct merge_input *heap = emalloc((n > 0 ? n : 1) * sizeof heap[0]);
+    char *key = NULL;
+    int key_capacity = 0;
+    int len, freq, size = 0;
+    int i, status, ok = 1;
+    for (i = 0; i < n; i++){
+        heap[size].reader = inputs[i];
+        if ((status = snapshot_reader_next(inputs[i], &heap[size].key,
+                                           &heap[size].freq)) > 0){
+            size++;
+        }else if (status < 0){
+            ok = 0;
+        }
+    }
+    for (i = size / 2 - 1; i >= 0; i--){
+        sift_down(heap, size, i);
+    }
+    while (ok && size > 0){
+        /* copy the smallest key, as reading on from its input replaces it */
+        len = strlen(heap[0].key);
+        if (len + 1 > key_capacity){
+            key_capacity = len + 1;
+            key = erealloc(key, key_capacity);
+        }
+        strcpy(key, heap[0].key);
+        freq = 0;
+        while (size > 0 && strcmp(heap[0].key, key) == 0){
+            freq += heap[0].freq;
+            if ((status = snapshot_reader_next(heap[0].reader, &heap[0].key,
+                                               &heap[0].freq)) <= 0){
+                ok = ok && status == 0;
+                heap[0] = heap[--size];
+            }
+            sift_down(heap, size, 0);
+        }
+        f(key, freq, arg);
+    }
+    free(key);
+    free(heap);
+    if (!ok){
+        fprintf(stderr, "Snapshot is corrupt or out of order.\n");
+    }
+    return ok;
+}
@@ -0,0 +1,22 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <stdio.h>
+#include "htable.h"
+#include "tree.h"
+
+typedef struct snapshot_writerrec *snapshot_writer;
+typedef struct snapshot_readerrec *snapshot_reader;
+
+extern snapshot_writer snapshot_writer_new(FILE *stream);
+extern void snapshot_writer_add(snapshot_writer s, char *key, int freq);
+extern void snapshot_writer_free(snapshot_writer s);
+extern snapshot_reader snapshot_reader_new(FILE *stream);
+extern int snapshot_reader_next(snapshot_reader s, char **key, int *freq);
+extern void snapshot_reader_free(snapshot_reader s);
+extern void snapshot_save_htable(htable h, FILE *stream);
+extern void snapshot_save_tree(tree b, FILE *stream);
+extern int snapshot_merge(snapshot_reader *inputs, int n,
+                          void f(char *key, int freq, void *arg), void *arg);
+
+#endif
@@ -0,0 +1,393 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "suggest.h"
+#include "mylib.h"
+
+/* Largest edit distance a suggestion can be from the word. */
+#define SUGGEST_DISTANCE 2
+
+/* Only deletes from the first SUGGEST_PREFIX characters of a word are
+ * indexed, which keeps the index to 1 + 7 + 21 = 29 entries per word.
+ * Candidates are still checked against the whole word, so this can
+ * only miss suggestions whose edits push characters across the end of
+ * the prefix, e.g. two letters inserted at the start of a long word.
+ */
+#define SUGGEST_PREFIX 7
+#define MAX_DELETES 29
+
+/* Average number of entries per bucket. */
+#define SUGGEST_LOAD 4
+
+/* Longest word that can be looked up, as for getword. */
+#define MAX_WORD 256
+
+/* An index entry: the hash of a string made by deleting up to
+ * SUGGEST_DISTANCE characters from a word's prefix, and the word.
+ */
+struct entry {
+    unsigned int hash;
+    int word;
+};
+
+/* A symmetric delete index for spelling suggestions. If two words are
+ * within SUGGEST_DISTANCE edits of each other then deleting at most
+ * SUGGEST_DISTANCE characters from each gives the same string, so a
+ * lookup only has to generate the deletes of the word being looked up
+ * and check the dictionary words that share one, rather than comparing
+ * it with every word. Deletes are stored by hash, which can only add
+ * candidates; they are all checked with a real edit distance.
+ *
+ * The words are copied into one packed blob. The entries are bucketed
+ * on the low bits of their hash, so bucket b is entries
+ * [start[b], start[b + 1]).
+ */
+struct suggestrec {
+    char *blob;
+    size_t blob_len;
+    size_t blob_capacity;
+    int *offsets;
+    int *freqs;
+    int num_words;
+    int words_capacity;
+    struct entry *entries;
+    int num_entries;
+    int *start;
+    unsigned int mask;
+};
+
+/* A candidate suggestion. */
+struct candidate {
+    int word;
+    int distance;
+};
+
+/* Hashes a word with up to two characters left out, using FNV-1a
+ * followed by the murmur3 finaliser so the low bits can be used to
+ * pick a bucket.
+ *
+ * @param word the word
+ * @param len the length of the word
+ * @param skip1 position of a character to leave out, or -1
+ * @param skip2 position of another character to leave out, or -1
+ *
+ * @return the hash
+ */
+static unsigned int delete_hash(char *word, int len, int skip1, int skip2){
+    unsigned int h = 2166136261u;
+    int i;
+    for (i = 0; i < len; i++){
+        if (i != skip1 && i != skip2){
+            h ^= (unsigned char) word[i];
+            h = (h * 16777619u) & 0xffffffffu;
+        }
+    }
+    return hash_mix(h);
+}
+
+/* Finds the hashes of every distinct string made by deleting up to
+ * SUGGEST_DISTANCE characters from the prefix of a word.
+ *
+ * @param word the word
+ * @param hashes array of at least MAX_DELETES to store the hashes in
+ *
+ * @return the number of hashes stored
+ */
+static int delete_hashes(char *word, unsigned int *hashes){
+    int len = strlen(word);
+    int n = 0;
+    int i, j;
+    unsigned int h;
+    if (len > SUGGEST_PREFIX){
+        len = SUGGEST_PREFIX;
+    }
+    hashes[n++] = delete_hash(word, len, -1, -1);
+    for (i = 0; i < len; i++){
+        hashes[n++] = delete_hash(word, len, i, -1);
+        for (j = i + 1; j < len; j++){
+            hashes[n++] = delete_hash(word, len, i, j);
+        }
+    }
+    /* insertion sort and drop repeats, e.g. from doubled letters */
+    for (i = 1; i < n; i++){
+        h = hashes[i];
+        for (j = i; j > 0 && hashes[j - 1] > h; j--){
+            hashes[j] = hashes[j - 1];
+        }
+        hashes[j] = h;
+    }
+    for (i = j = 0; i < n; i++){
+        if (j == 0 || hashes[j - 1] != hashes[i]){
+            hashes[j++] = hashes[i];
+        }
+    }
+    return j;
+}
+
+/* Finds the optimal string alignment distance between two words, i.e.
+ * the edit distance counting an adjacent transposition as one edit.
+ *
+ * @param a the first word
+ * @param la the length of a
+ * @param b the second word
+ * @param lb the length of b
+ *
+ * @return the distance, or SUGGEST_DISTANCE + 1 if it is greater
+ * than SUGGEST_DISTANCE
+ */
+static int distance(char *a, int la, char *b, int lb){
+    int rows[3][MAX_WORD + 1];
+    int *prev2 = rows[0], *prev = rows[1], *cur = rows[2], *tmp;
+    int i, j, d, best;
+    if (la - lb > SUGGEST_DISTANCE || lb - la > SUGGEST_DISTANCE
+        || la > MAX_WORD || lb > MAX_WORD){
+        return SUGGEST_DISTANCE + 1;
+    }
+    for (j = 0; j <= lb; j++){
+        prev[j] = j;
+    }
+    for (i = 1; i <= la; i++){
+        cur[0] = best = i;
+        for (j = 1; j <= lb; j++){
+            d = prev[j - 1] + (a[i - 1] != b[j - 1]);
+            if (prev[j] + 1 < d){
+                d = prev[j] + 1;
+            }
+            if (cur[j - 1] + 1 < d){
+                d = cur[j - 1] + 1;
+            }
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]
+                && prev2[j - 2] + 1 < d){
+                d = prev2[j - 2] + 1;
+            }
+            cur[j] = d;
+            if (d < best){
+                best = d;
+            }
+        }
+        if (best > SUGGEST_DISTANCE){
+            return SUGGEST_DISTANCE + 1;
+        }
+        tmp = prev2;
+        prev2 = prev;
+        prev = cur;
+        cur = tmp;
+    }
+    return prev[lb] > SUGGEST_DISTANCE ? SUGGEST_DISTANCE + 1 : prev[lb];
+}
+
+/* Copies a word and its frequency into an index being built. */
+static void add_word(char *word, int freq, void *arg){
+    suggest s = arg;
+    size_t len = strlen(word) + 1;
+    if (s->num_words == s->words_capacity){
+        s->words_capacity = 2 * s->words_capacity + 1024;
+        s->offsets = erealloc(s->offsets,
+                              s->words_capacity * sizeof s->offsets[0]);
+        s->freqs = erealloc(s->freqs, s->words_capacity * sizeof s->freqs[0]);
+    }
+    if (s->blob_len + len > s->blob_capacity){
+        s->blob_capacity = 2 * (s->blob_capacity + len);
+        s->blob = erealloc(s->blob, s->blob_capacity);
+    }
+    memcpy(s->blob + s->blob_len, word, len);
+    s->offsets[s->num_words] = s->blob_len;
+    s->freqs[s->num_words] = freq;
+    s->blob_len += len;
+    s->num_words++;
+}
+
+/* Creates an empty index to add words to. */
+static suggest suggest_empty(void){
+    suggest result = emalloc(sizeof *result);
+    result->blob = NULL;
+    result->blob_len = 0;
+    result->blob_capacity = 0;
+    result->offsets = NULL;
+    result->freqs = NULL;
+    result->num_words = 0;
+    result->words_capacity = 0;
+    return result;
+}
+
+/* Indexes the deletes of every word that has been added. The entries
+ * are generated into a scratch array, then counting sorted into their
+ * buckets.
+ *
+ * @param s the index to build
+ *
+ * @return the finished index
+ */
+static suggest suggest_build(suggest s){
+    unsigned int hashes[MAX_DELETES];
+    struct entry *scratch;
+    int capacity = 1024;
+    int buckets = 1;
+    int i, j, n;
+    scratch = emalloc(capacity * sizeof scratch[0]);
+    s->num_entries = 0;
+    for (i = 0; i < s->num_words; i++){
+        n = delete_hashes(s->blob + s->offsets[i], hashes);
+        if (s->num_entries + n > capacity){
+            capacity *= 2;
+            scratch = erealloc(scratch, capacity * sizeof scratch[0]);
+        }
+        for (j = 0; j < n; j++){
+            scratch[s->num_entries].hash = hashes[j];
+            scratch[s->num_entries].word = i;
+            s->num_entries++;
+        }
+    }
+    while (buckets * SUGGEST_LOAD < s->num_entries){
+        buckets *= 2;
+    }
+    s->mask = buckets - 1;
+    s->start = emalloc((buckets + 1) * sizeof s->start[0]);
+    for (i = 0; i <= buckets; i++){
+        s->start[i] = 0;
+    }
+    for (i = 0; i < s->num_entries; i++){
+        s->start[(scratch[i].hash & s->mask) + 1]++;
+    }
+    for (i = 0; i < buckets; i++){
+        s->start[i + 1] += s->start[i];
+    }
+    s->entries = emalloc((s->num_entries > 0 ? s->num_entries : 1)
+                         * sizeof s->entries[0]);
+    for (i = 0; i < s->num_entries; i++){
+        s->entries[s->start[scratch[i].hash & s->mask]++] = scratch[i];
+    }
+    /* filling moved each start along to the next bucket's */
+    for (i = buckets; i > 0; i--){
+        s->start[i] = s->start[i - 1];
+    }
+    s->start[0] = 0;
+    free(scratch);
+    return s;
+}
+
+/* Builds a suggestion index over the words in a hash table.
+ *
+ * @param h the hash table
+ *
+ * @return new suggestion index
+ */
+suggest suggest_new_htable(htable h){
+    suggest result = suggest_empty();
+    htable_walk(h, add_word, result);
+    return suggest_build(result);
+}
+
+/* Builds a suggestion index over the words in a tree.
+ *
+ * @param b the tree
+ *
+ * @return new suggestion index
+ */
+suggest suggest_new_tree(tree b){
+    suggest result = suggest_empty();
+    tree_walk(b, add_word, result);
+    return suggest_build(result);
+}
+
+/* Frees a suggestion index.
+ *
+ * @param s the index to free
+ */
+void suggest_free(suggest s){
+    free(s->blob);
+    free(s->offsets);
+    free(s->freqs);
+    free(s->entries);
+    free(s->start);
+    free(s);
+}
+
+/* Returns true if candidate a should be suggested before candidate b:
+ * closer words first, then more frequent words, then in strcmp order.
+ */
+static int candidate_before(suggest s, struct candidate *a,
+                            struct candidate *b){
+    if (a->distance != b->distance){
+        return a->distance < b->distance;
+    }
+    if (s->freqs[a->word] != s->freqs[b->word]){
+        return s->freqs[a->word] > s->freqs[b->word];
+    }
+    return strcmp(s->blob + s->offsets[a->word],
+                  s->blob + s->offsets[b->word]) < 0;
+}
+
+/* Finds the best suggestions for a word: the dictionary words within
+ * SUGGEST_DISTANCE edits of it, closest and then most frequent first.
+ * The index is only read, so several threads can look words up at once.
+ *
+ * @param s the suggestion index
+ * @param word the word to find suggestions for
+ * @param results array to store pointers to the suggested words in
+ * @param max the size of results
+ *
+ * @return the number of suggestions stored
+ */
+int suggest_lookup(suggest s, char *word, char **results, int max){
+    unsigned int hashes[MAX_DELETES];
+    struct candidate best[SUGGEST_MAX];
+    struct candidate c;
+    struct entry *e, *end;
+    char *key;
+    int len = strlen(word);
+    int num_best = 0;
+    int i, j, n;
+    if (max > SUGGEST_MAX){
+        max = SUGGEST_MAX;
+    }
+    n = delete_hashes(word, hashes);
+    for (i = 0; i < n; i++){
+        e = s->entries + s->start[hashes[i] & s->mask];
+        end = s->entries + s->start[(hashes[i] & s->mask) + 1];
+        for (; e < end; e++){
+            if (e->hash != hashes[i]){
+                continue;
+            }
+            /* a word can share several deletes; skip ones already kept */
+            for (j = 0; j < num_best && best[j].word != e->word; j++){
+                ;
+            }
+            if (j < num_best){
+                continue;
+            }
+            key = s->blob + s->offsets[e->word];
+            c.word = e->word;
+            c.distance = distance(word, len, key, strlen(key));
+            if (c.distance > SUGGEST_DISTANCE || c.distance == 0){
+                continue;
+            }
+            if (num_best == max && !candidate_before(s, &c, &best[max - 1])){
+                continue;
+            }
+            if (num_best < max){
+                num_best++;
+            }
+            for (j = num_best - 1; j > 0 && candidate_before(s, &c, &best[j - 1]);
+                 j--){
+                best[j] = best[j - 1];
+            }
+            best[j] = c;
+        }
+    }
+    for (i = 0; i < num_best; i++){
+        results[i] = s->blob + s->offsets[best[i].word];
+    }
+    return num_best;
+}
+
+/* Returns the number of bytes used by a suggestion index.
+ *
+ * @param s the suggestion index
+ */
+size_t suggest_memory(suggest s){
+    return sizeof *s + s->blob_capacity
+        + s->words_capacity * (sizeof s->offsets[0] + sizeof s->freqs[0])
+        + (s->mask + 2) * sizeof s->start[0]
+        + s->num_entries * sizeof s->entries[0];
+}
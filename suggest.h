@@ -0,0 +1,19 @@
+#ifndef SUGGEST_H_
+#define SUGGEST_H_
+
+#include <stddef.h>
+#include "htable.h"
+#include "tree.h"
+
+/* Most suggestions given for a word. */
+#define SUGGEST_MAX 5
+
+typedef struct suggestrec *suggest;
+
+extern suggest suggest_new_htable(htable h);
+extern suggest suggest_new_tree(tree b);
+extern void suggest_free(suggest s);
+extern int suggest_lookup(suggest s, char *word, char **results, int max);
+extern size_t suggest_memory(suggest s);
+
+#endif
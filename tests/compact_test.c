@@ -0,0 +1,116 @@
+/* Checks that deleting words from a hash table never loses any of the
+ * words left in it, in particular when enough tombstones build up for
+ * htable_delete to compact the table. For each probing method and a
+ * range of small table sizes, a table is filled with random words until
+ * it is full, then words are deleted one at a time, checking after each
+ * delete that every remaining word is still found and the deleted ones
+ * aren't. It also checks that htable_decrement keeps a word until its
+ * frequency reaches zero, then removes it and leaves a tombstone.
+ *
+ * The test includes htable.c itself so it can look at the slots.
+ * Build and run from the top of the repo with tests/run_tests.sh.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "htable.c"
+
+#define NUM_SEEDS 3000
+#define MAX_WORDS 64
+
+static const int capacities[] = { 7, 11, 13, 17, 31, 61 };
+static const char *names[] = { "linear", "double", "quadratic", "cuckoo" };
+
+/* Fills and empties one table, returning the number of failed checks. */
+static int run(hashing_t method, int capacity, unsigned int seed){
+    htable h = htable_new(capacity, method, 0);
+    char words[MAX_WORDS][32];
+    int live[MAX_WORDS];
+    int n, i, j, failures = 0;
+    srand(seed);
+    for (n = 0; n < MAX_WORDS; n++){
+        /* mostly short words, with some long enough to be stored apart */
+        sprintf(words[n], rand() % 4 ? "w%d" : "longer_word_%d", rand());
+        for (j = 0; j < n && strcmp(words[j], words[n]) != 0; j++){
+            ;
+        }
+        if (j < n || !htable_insert(h, words[n])){
+            break;
+        }
+        live[n] = 1;
+    }
+    for (i = 0; i < n; i++){
+        j = rand() % n;
+        if (!live[j]){
+            continue;
+        }
+        htable_delete(h, words[j]);
+        live[j] = 0;
+        for (j = 0; j < n; j++){
+            if (htable_search(h, words[j]) != live[j]){
+                failures++;
+            }
+        }
+    }
+    htable_free(h);
+    return failures;
+}
+
+/* Decrements a short (inline) and a long (separately stored) word from
+ * a table, returning the number of failed checks.
+ */
+static int decrement(hashing_t method, char *word){
+    htable h = htable_new(113, method, 0);
+    unsigned int len = strlen(word);
+    int pos, probes, failures = 0;
+    htable_insert(h, word);
+    htable_insert(h, word);
+    htable_insert(h, "other");
+    pos = h->probe->find(h, word, htable_hash(h, word, len), len, &probes);
+    if (htable_decrement(h, word) != 1 || !htable_search(h, word)){
+        failures++;
+    }
+    if (htable_decrement(h, word) != 0 || htable_search(h, word)){
+        failures++;
+    }
+    /* cuckoo hashing frees the slot rather than leaving a tombstone */
+    if (method == CUCKOO_H ? h->slots[pos].freq != 0
+        : h->slots[pos].freq != TOMBSTONE || h->num_tombstones != 1){
+        failures++;
+    }
+    if (h->num_keys != 1 || !htable_search(h, "other")
+        || htable_decrement(h, word) != 0){
+        failures++;
+    }
+    htable_free(h);
+    return failures;
+}
+
+int main(void){
+    int failures = 0, bad;
+    int c, m;
+    unsigned int seed;
+    for (m = LINEAR_P; m <= CUCKOO_H; m++){
+        for (c = 0; c < (int) (sizeof capacities / sizeof capacities[0]); c++){
+            bad = 0;
+            for (seed = 0; seed < NUM_SEEDS; seed++){
+                if (run((hashing_t) m, capacities[c], seed) > 0){
+                    bad++;
+                }
+            }
+            if (bad > 0){
+                printf("FAIL: %s, capacity %d: %d of %d seeds lost words\n",
+                       names[m], capacities[c], bad, NUM_SEEDS);
+            }
+            failures += bad;
+        }
+        bad = decrement((hashing_t) m, "short")
+            + decrement((hashing_t) m, "a_word_too_long_to_store_inline");
+        if (bad > 0){
+            printf("FAIL: %s: htable_decrement\n", names[m]);
+        }
+        failures += bad;
+    }
+    printf("compact_test: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
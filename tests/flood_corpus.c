@@ -0,0 +1,50 @@
+/* Prints words that all collide in an unkeyed hash table, for testing
+ * hash flooding detection. Every word hashes to the same value modulo
+ * the table size, so without keyed hashing they all share one probe
+ * sequence.
+ *
+ * Usage: flood_corpus WORDS TABLESIZE
+ *
+ * The hash must match htable_word_to_int in htable.c.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WORD_LEN 6
+
+/* The unkeyed hash from htable.c. */
+static unsigned int word_to_int(char *word){
+    unsigned int result = 0;
+    while (*word != '\0'){
+        result = (*word++ + 31 * result);
+    }
+    return result;
+}
+
+int main(int argc, char **argv){
+    char word[WORD_LEN + 1];
+    unsigned long i, limit = 1;
+    int n, m, found = 0;
+    int j;
+    if (argc != 3 || (n = atoi(argv[1])) <= 0 || (m = atoi(argv[2])) <= 0){
+        fprintf(stderr, "Usage: %s WORDS TABLESIZE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    for (j = 0; j < WORD_LEN; j++){
+        limit *= 26;
+    }
+    word[WORD_LEN] = '\0';
+    /* count through every lowercase word, keeping those that hash to 7 */
+    for (i = 0; i < limit && found < n; i++){
+        unsigned long x = i;
+        for (j = WORD_LEN - 1; j >= 0; j--){
+            word[j] = 'a' + x % 26;
+            x /= 26;
+        }
+        if (word_to_int(word) % m == 7){
+            puts(word);
+            found++;
+        }
+    }
+    return found == n ? EXIT_SUCCESS : EXIT_FAILURE;
+}
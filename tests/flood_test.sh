@@ -0,0 +1,73 @@
+#!/bin/sh
+# Feeds a corpus of colliding words to the program and checks that the
+# table raises flood alerts but keeps its unkeyed hash, and that with -k
+# the words don't collide and the longest probe stays bounded. Also
+# checks that ordinary words, which the unkeyed hash packs closely,
+# raise no alerts and give the same output every run.
+#
+# Usage: flood_test.sh ASGN FLOOD_CORPUS
+
+ASGN=$1
+CORPUS=$2
+WORDS=400
+TABLE=1009          # prime, so asgn uses it as the table size
+MAX_PROBES=128      # FLOOD_PROBES in htable.c
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+status=0
+
+fail(){
+    echo "flood_test: FAIL: $1"
+    status=1
+}
+
+# The longest probe of any new insert, from the htable_print_stats table.
+max_insert_probes(){
+    awk '/^Insert \(new\)/ && NF == 5 { print $5 }' "$1"
+}
+
+"$CORPUS" $WORDS $TABLE > "$TMP/words" || fail "couldn't generate corpus"
+
+"$ASGN" -t $TABLE -p < "$TMP/words" > "$TMP/out" 2> "$TMP/err"
+grep -q 'possible hash flooding' "$TMP/err" \
+    || fail "expected a flood warning without -k"
+grep -q '^Keyed hashing : off' "$TMP/out" \
+    || fail "table changed its hash without -k"
+grep -q '^Flood alerts  : [1-9]' "$TMP/out" \
+    || fail "stats don't report the flood alerts"
+
+"$ASGN" -t $TABLE -c "$TMP/words" < "$TMP/words" > "$TMP/out" 2> "$TMP/err"
+[ -s "$TMP/err" ] && fail "flood warning mixed into the unknown words"
+grep -q '^Flood alerts  : [1-9]' "$TMP/out" \
+    || fail "check mode doesn't report the flood alerts"
+
+"$ASGN" -k -t $TABLE -p < "$TMP/words" > "$TMP/out" 2> "$TMP/err"
+grep -q 'possible hash flooding' "$TMP/err" \
+    && fail "unexpected flood warning with -k"
+grep -q '^Flood alerts  : 0' "$TMP/out" \
+    || fail "stats report flood alerts with -k"
+[ "$(max_insert_probes "$TMP/out")" -le $MAX_PROBES ] \
+    || fail "probe length not bounded with -k"
+
+# every two and three letter word
+awk 'BEGIN {
+    a = "abcdefghijklmnopqrstuvwxyz"
+    for (i = 1; i <= 26; i++) {
+        for (j = 1; j <= 26; j++) {
+            print substr(a, i, 1) substr(a, j, 1)
+            for (k = 1; k <= 26; k++) {
+                print substr(a, i, 1) substr(a, j, 1) substr(a, k, 1)
+            }
+        }
+    }
+}' > "$TMP/short"
+for size in 50000 1000000; do
+    "$ASGN" -t $size < "$TMP/short" > "$TMP/out1" 2> "$TMP/err"
+    [ -s "$TMP/err" ] && fail "flood warning for short words with -t $size"
+    "$ASGN" -t $size < "$TMP/short" > "$TMP/out2" 2>&1
+    cmp -s "$TMP/out1" "$TMP/out2" \
+        || fail "output differs between runs with -t $size"
+done
+
+[ $status = 0 ] && echo "flood_test: ok"
+exit $status
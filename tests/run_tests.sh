@@ -0,0 +1,20 @@
+#!/bin/sh
+# Builds and runs the tests. Run from the top of the repo:
+#     sh tests/run_tests.sh
+# Set CC or CFLAGS to override the compiler and its flags.
+
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O2 -W -Wall -ansi -pedantic"}
+BIN=$(mktemp -d)
+trap 'rm -rf "$BIN"' EXIT
+status=0
+
+$CC $CFLAGS -I. tests/compact_test.c mylib.c writer.c mph.c \
+    -o "$BIN/compact_test" -lm || exit 1
+"$BIN/compact_test" || status=1
+
+$CC $CFLAGS *.c -o "$BIN/asgn" -lm -lpthread || exit 1
+$CC $CFLAGS tests/flood_corpus.c -o "$BIN/flood_corpus" || exit 1
+sh tests/flood_test.sh "$BIN/asgn" "$BIN/flood_corpus" || status=1
+
+exit $status
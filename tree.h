@@ -11,8 +11,11 @@ extern void tree_inorder(tree b, void f(char *str, int f));
 extern tree tree_insert(tree b, char *str, tree_t t);
 extern tree tree_new();
 extern void tree_preorder(tree b, void f(char *str, int f));
+extern void tree_walk(tree b, void f(char *str, int freq, void *arg), void *arg);
 extern int tree_search(tree b, char *str);
 extern void tree_print_key(char *str, int f);
+extern void tree_print_preorder(tree b, FILE *stream);
+extern void tree_print_inorder(tree b, FILE *stream);
 extern void tree_output_dot(tree t, FILE *out);
 extern tree tree_make_black(tree t);
 
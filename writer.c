@@ -0,0 +1,125 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include "writer.h"
+#include "mylib.h"
+
+#define WRITER_BUFFER_SIZE 65536
+
+/* A buffered writer for printing large amounts of output. Output is
+ * formatted straight into a large buffer and written to the underlying
+ * file descriptor with as few write calls as possible, bypassing stdio.
+ */
+struct writerrec {
+    int fd;
+    int len;
+    char buffer[WRITER_BUFFER_SIZE];
+};
+
+/* Creates a writer for a stream. Anything already buffered by stdio for
+ * the stream is flushed first so output stays in order.
+ *
+ * @param stream the stream to write to
+ *
+ * @return new writer
+ */
+writer writer_new(FILE *stream){
+    writer result = emalloc(sizeof *result);
+    fflush(stream);
+    result->fd = fileno(stream);
+    result->len = 0;
+    return result;
+}
+
+/* Writes out everything in the buffer.
+ *
+ * @param w the writer to flush
+ */
+void writer_flush(writer w){
+    char *p = w->buffer;
+    ssize_t n;
+    while (w->len > 0){
+        n = write(w->fd, p, w->len);
+        if (n < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            break; /* nowhere to report it, same as a failed fprintf */
+        }
+        p += n;
+        w->len -= n;
+    }
+    w->len = 0;
+}
+
+/* Flushes and frees a writer. The stream it was made from is not closed.
+ *
+ * @param w the writer to free
+ */
+void writer_free(writer w){
+    writer_flush(w);
+    free(w);
+}
+
+/* Writes a single character.
+ *
+ * @param w the writer to use
+ * @param c the character to write
+ */
+void writer_char(writer w, char c){
+    if (w->len == WRITER_BUFFER_SIZE){
+        writer_flush(w);
+    }
+    w->buffer[w->len++] = c;
+}
+
+/* Writes a string, not including its terminating '\0'.
+ *
+ * @param w the writer to use
+ * @param s the string to write
+ */
+void writer_string(writer w, char *s){
+    while (*s != '\0'){
+        if (w->len == WRITER_BUFFER_SIZE){
+            writer_flush(w);
+        }
+        w->buffer[w->len++] = *s++;
+    }
+}
+
+/* Writes an integer padded with spaces to a minimum width, giving the
+ * same output as printf("%*d", width, n). A negative width left
+ * justifies the number.
+ *
+ * @param w the writer to use
+ * @param n the integer to write
+ * @param width minimum number of characters to write
+ */
+void writer_int(writer w, int n, int width){
+    char digits[16];
+    int len = 0;
+    int pad;
+    unsigned int u = n < 0 ? 0u - (unsigned int) n : (unsigned int) n;
+    do {
+        digits[len++] = '0' + u % 10;
+        u /= 10;
+    } while (u > 0);
+    if (n < 0){
+        digits[len++] = '-';
+    }
+    pad = (width < 0 ? -width : width) - len;
+    if (w->len + len + (pad > 0 ? pad : 0) > WRITER_BUFFER_SIZE){
+        writer_flush(w);
+    }
+    for (; width > 0 && pad > 0; pad--){
+        w->buffer[w->len++] = ' ';
+    }
+    while (len > 0){
+        w->buffer[w->len++] = digits[--len];
+    }
+    for (; pad > 0; pad--){
+        w->buffer[w->len++] = ' ';
+    }
+}
@@ -0,0 +1,15 @@
+#ifndef WRITER_H_
+#define WRITER_H_
+
+#include <stdio.h>
+
+typedef struct writerrec *writer;
+
+extern writer writer_new(FILE *stream);
+extern void writer_free(writer w);
+extern void writer_flush(writer w);
+extern void writer_char(writer w, char c);
+extern void writer_string(writer w, char *s);
+extern void writer_int(writer w, int n, int width);
+
+#endif